@@ -0,0 +1,24 @@
+#ifndef ADVECTION_HPP_INCLUDED
+#define ADVECTION_HPP_INCLUDED
+
+#include "FluidSolver.hpp"
+
+
+/* Semi-Lagrangian advection: each interior cell of dst takes the value src had at the position
+ * its center comes from, going back dt along (velX, velY), bilinearly interpolated.
+ * Back-traced positions are clamped between the centers of the outer ring, so that the four cells
+ * read always exist. The outer ring of dst is left untouched.
+ * With SIMD enabled (see Simd.hpp), a whole vector of cells is back-traced at once and the
+ * four corners are fetched with gathers; when dst is too large to stay in cache, it is written
+ * with non-temporal stores. Lines of all the buffers are pitch cells apart. */
+void advectField (BufferFloat const& src, BufferFloat& dst, BufferFloat const& velX, BufferFloat const& velY,
+                  unsigned int nbCols, unsigned int nbLines, unsigned int pitch, float dt);
+
+/* advectField for several fields carried by the same velocities: srcs[i] is advected into dsts[i].
+ * The back-trace and the interpolation weights of each cell are computed once for all of them,
+ * so velX and velY may be among the sources (self-advection), but not among the destinations. */
+void advectFields (BufferFloat const* const* srcs, BufferFloat* const* dsts, unsigned int nbFields,
+                   BufferFloat const& velX, BufferFloat const& velY,
+                   unsigned int nbCols, unsigned int nbLines, unsigned int pitch, float dt);
+
+#endif // ADVECTION_HPP_INCLUDED
@@ -0,0 +1,75 @@
+#ifndef BOUNDARIES_HPP_INCLUDED
+#define BOUNDARIES_HPP_INCLUDED
+
+#include "FluidSolver.hpp"
+
+
+/* Sets the outer ring of a nbCols x nbLines grid, whose lines are pitch cells apart, from its interior
+ * neighbours: left/right columns are multiplied by hFactor, top/bottom lines by vFactor,
+ * corners are the average of their two neighbours. */
+void applyBoundaryConditions (BufferFloat& buffer, unsigned int nbCols, unsigned int nbLines, unsigned int pitch,
+                              float hFactor, float vFactor);
+
+/* The cells of the outer ring which depend on the interior line `line`: its first and last cells, and
+ * the first (last) line of the grid with the first (last) interior line. Calling it for every interior
+ * line, in any order, sets the whole ring as applyBoundaryConditions does. Kernels going over the grid
+ * line by line call it as soon as they are done with a line, which is then still in cache: the ring
+ * costs no pass of its own, whose accesses to the first and last columns would be a line apart. */
+inline void applyBoundaryLine (BufferFloat& buffer, unsigned int nbCols, unsigned int nbLines, unsigned int pitch,
+                               unsigned int line, float hFactor, float vFactor)
+{
+    float* cells = buffer.data();
+    cells[line*pitch] = hFactor * cells[line*pitch + 1];
+    cells[line*pitch + nbCols-1] = hFactor * cells[line*pitch + nbCols-2];
+
+    if (line == 1) {
+        for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+            cells[col] = vFactor * cells[pitch + col];
+        }
+        cells[0] = 0.5f * (cells[pitch] + cells[1]);
+        cells[nbCols-1] = 0.5f * (cells[pitch + nbCols-1] + cells[nbCols-2]);
+    }
+    if (line == nbLines-2) {
+        const unsigned int lastLine = (nbLines-1)*pitch;
+        for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+            cells[lastLine + col] = vFactor * cells[lastLine - pitch + col];
+        }
+        cells[lastLine] = 0.5f * (cells[lastLine - pitch] + cells[lastLine + 1]);
+        cells[lastLine + nbCols-1] = 0.5f * (cells[lastLine - pitch + nbCols-1] + cells[lastLine + nbCols-2]);
+    }
+}
+
+/* The boundary conditions of each field, as compile-time policies the kernels are instantiated with.
+ * A policy provides:
+ *  - applyLine(buffer, nbCols, nbLines, pitch, line), the applyBoundaryLine of the field;
+ *  - apply(buffer, nbCols, nbLines, pitch), for the whole ring;
+ *  - hFactor() and vFactor(), for the solvers which fold the boundaries into their matrix.
+ * Other kinds of boundaries (periodic, obstacles) only need to provide the same interface. */
+
+/* Same as applyBoundaryConditions with constant factors */
+template <int H, int V>
+struct ReflectiveBoundaries
+{
+    static float hFactor() { return H; }
+    static float vFactor() { return V; }
+
+    static void applyLine (BufferFloat& buffer, unsigned int nbCols, unsigned int nbLines, unsigned int pitch,
+                           unsigned int line)
+    {
+        applyBoundaryLine(buffer, nbCols, nbLines, pitch, line, H, V);
+    }
+
+    static void apply (BufferFloat& buffer, unsigned int nbCols, unsigned int nbLines, unsigned int pitch)
+    {
+        for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+            applyLine(buffer, nbCols, nbLines, pitch, line);
+        }
+    }
+};
+
+struct DensityBoundaries: public ReflectiveBoundaries<1, 1> {};
+struct VelXBoundaries: public ReflectiveBoundaries<-1, 1> {}; //no flow through the left and right walls
+struct VelYBoundaries: public ReflectiveBoundaries<1, -1> {}; //no flow through the top and bottom walls
+struct PressureBoundaries: public ReflectiveBoundaries<1, 1> {};
+
+#endif // BOUNDARIES_HPP_INCLUDED
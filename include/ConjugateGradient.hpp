@@ -0,0 +1,78 @@
+#ifndef CONJUGATEGRADIENT_HPP_INCLUDED
+#define CONJUGATEGRADIENT_HPP_INCLUDED
+
+#include <vector>
+
+#include "FluidSolver.hpp"
+
+
+/* Preconditioned conjugate gradient for the 5-point systems of the simulation:
+ *     diag*x - coupling*(sum of the 4 neighbours of x) = rhs
+ * on the interior of the grid, its outer ring following applyBoundaryConditions.
+ * The outer ring is folded into the matrix (a neighbour on the ring is the cell itself
+ * times hFactor or vFactor), which keeps it symmetric, so the ring of x is only written
+ * when the solve is over. The work buffers are only written on the interior: their ring stays 0,
+ * so that the kernels can read the 4 neighbours of every interior cell without testing for the ring. */
+class ConjugateGradient
+{
+    public:
+        /* Lines of the buffers are pitch cells apart */
+        ConjugateGradient (unsigned int nbCols, unsigned int nbLines, unsigned int pitch);
+
+        /* Improves x until the residual is below tolerance * |rhs| (2-norm)
+         * or maxIterations have been done. */
+        SolveStats solve (BufferFloat& x, BufferFloat const& rhs, float diag, float coupling,
+                          float hFactor, float vFactor, Preconditioner preconditioner,
+                          float tolerance, unsigned int maxIterations);
+
+    private:
+        /* A system and the preconditioner built for it */
+        struct System
+        {
+            float diag;
+            float coupling;
+            float hFactor;
+            float vFactor;
+            Preconditioner preconditioner;
+            bool singular;
+
+            BufferFloat matrixDiag; //diagonal of A, boundaries included
+            BufferFloat precon; //inverse of the diagonal (Jacobi) or of the MIC(0) pivots
+        };
+
+        /* Selects the system of these parameters, building its matrix and preconditioner when they changed */
+        void prepare (float diag, float coupling, float hFactor, float vFactor, Preconditioner preconditioner);
+
+        /* MIC(0) pivots of the matrix of system */
+        void buildIncompleteCholesky (System& system) const;
+
+        /* q = A.s */
+        void multiply (BufferFloat const& s, BufferFloat& q) const;
+
+        /* z = M^-1.r */
+        void precondition (BufferFloat const& r, BufferFloat& z);
+        void applyIncompleteCholesky (BufferFloat const& r, BufferFloat& z) const;
+
+        double dot (BufferFloat const& a, BufferFloat const& b) const;
+
+        /* With pure Neumann boundaries the system is singular: removes the part of r that can't be solved */
+        void removeMean (BufferFloat& r) const;
+
+
+    private:
+        const unsigned int _nbCols;
+        const unsigned int _nbLines;
+        const unsigned int _pitch;
+
+        /* The pressure and the diffusions (one per boundary policy) take turns: each one keeps its
+         * preconditioner instead of rebuilding it at every solve, until its coefficients change (with dt) */
+        std::vector<System> _systems;
+        System const* _system; //the one being solved
+
+        BufferFloat _r;
+        BufferFloat _z;
+        BufferFloat _s;
+        BufferFloat _q;
+};
+
+#endif // CONJUGATEGRADIENT_HPP_INCLUDED
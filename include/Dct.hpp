@@ -0,0 +1,78 @@
+#ifndef DCT_HPP_INCLUDED
+#define DCT_HPP_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+/* Discrete cosine transforms of length n, built on a mixed-radix complex FFT. Lengths with a larger
+ * prime factor go through Bluestein's algorithm: a circular convolution by a power of two FFT.
+ * Transforms are done on `batch` independent signals at once: element k of signal b
+ * is data[k*batch + b], so every inner loop runs over the signals and gets vectorised. */
+class Dct
+{
+    public:
+        /* Largest prime factor of n handled by the mixed-radix FFT */
+        static const unsigned int MAX_PRIME_FACTOR = 13;
+
+        explicit Dct (unsigned int n);
+
+        unsigned int getSize() const;
+
+        /* Number of floats of scratch memory needed by forward() and inverse() */
+        std::size_t getWorkspaceSize (unsigned int batch) const;
+
+        /* DCT-II: X[k] = sum_j x[j] * cos(pi * (j+1/2) * k / n), in place */
+        void forward (float* data, unsigned int batch, float* workspace) const;
+
+        /* Exact inverse of forward(), in place */
+        void inverse (float* data, unsigned int batch, float* workspace) const;
+
+    private:
+        /* Number of floats of scratch memory needed by fft() */
+        std::size_t getScratchSize (unsigned int batch) const;
+
+        /* Forward complex FFT of (re, im), in place */
+        void fft (float* re, float* im, float* scratch, unsigned int batch) const;
+
+        /* Mixed-radix FFT, Stockham autosort ordering: tmpRe, tmpIm and butterfly are scratch memory */
+        void mixedRadix (float* re, float* im, float* tmpRe, float* tmpIm, float* butterfly, unsigned int batch) const;
+
+        /* X[k] = chirp[k] * sum_j x[j]*chirp[j] * conj(chirp[k-j]), the sum being a convolution */
+        void bluestein (float* re, float* im, float* scratch, unsigned int batch) const;
+
+        /* One butterfly of a stage: combines the inputs j + r*n/radix into the outputs
+         * (j/ns)*ns*radix + j%ns + q*ns, ns being the product of the previous radices. */
+        void radix2 (float const* inRe, float const* inIm, float* outRe, float* outIm,
+                     unsigned int j, unsigned int ns, unsigned int batch) const;
+        void radix4 (float const* inRe, float const* inIm, float* outRe, float* outIm,
+                     unsigned int j, unsigned int ns, unsigned int batch) const;
+        void radixGeneric (float const* inRe, float const* inIm, float* outRe, float* outIm,
+                           unsigned int radix, unsigned int j, unsigned int ns, unsigned int batch,
+                           float* butterfly) const;
+
+
+    private:
+        const unsigned int _n;
+        std::vector<unsigned int> _factors;
+        unsigned int _maxFactor;
+
+        /* exp(-2i*pi*k/n) */
+        std::vector<float> _rootsRe;
+        std::vector<float> _rootsIm;
+
+        /* exp(-i*pi*k/(2n)), for the DCT <-> FFT reordering */
+        std::vector<float> _shiftRe;
+        std::vector<float> _shiftIm;
+
+        /* Bluestein's algorithm, when _factors is empty: FFT of the convolution length m >= 2n-1,
+         * exp(-i*pi*k^2/n), and the FFT of its conjugate wrapped around m, divided by m */
+        std::unique_ptr<Dct> _convolution;
+        std::vector<float> _chirpRe;
+        std::vector<float> _chirpIm;
+        std::vector<float> _kernelRe;
+        std::vector<float> _kernelIm;
+};
+
+#endif // DCT_HPP_INCLUDED
@@ -0,0 +1,145 @@
+#ifndef FIELDARENA_HPP_INCLUDED
+#define FIELDARENA_HPP_INCLUDED
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+
+/* Pages backing the fields of a FluidSolver */
+enum class HugePages
+{
+    NONE, //regular pages
+    TRANSPARENT, //regular mapping, 2 MB aligned and advised for transparent huge pages (default)
+    EXPLICIT //reserved huge pages (MAP_HUGETLB), regular pages if none are available
+};
+
+/* Names of the modes on the command lines: none, transparent and explicit */
+bool parseHugePages (std::string const& name, HugePages& hugePages);
+std::string getHugePagesName (HugePages hugePages);
+
+/* One memory region holding all the fields of a FluidSolver, each one starting on a cache line.
+ * It is an anonymous mapping, so its pages are zero and only get committed when first touched:
+ * large grids are allocated at once, and only their first use pays for the memory.
+ * Memory is handed out in order and only given back when the arena is destroyed.
+ * On systems without mmap it is plain heap memory, zeroed at once. */
+class FieldArena
+{
+    public:
+        static const std::size_t ALIGNMENT = 64;
+
+        FieldArena (std::size_t capacity, HugePages hugePages);
+        ~FieldArena();
+
+        FieldArena (FieldArena const&) = delete;
+        FieldArena& operator= (FieldArena const&) = delete;
+
+        /* Zeroed and aligned on ALIGNMENT, nullptr when the arena is full */
+        void* allocate (std::size_t size);
+        bool contains (void const* memory) const;
+
+        /* Pages actually obtained, which may differ from the ones asked for */
+        HugePages getHugePages() const;
+        std::size_t getCapacity() const;
+        std::size_t getUsed() const;
+
+        /* Zeroed and aligned on ALIGNMENT, outside of any arena */
+        static void* allocateStandalone (std::size_t size);
+        static void freeStandalone (void* memory);
+
+    private:
+        unsigned char* _memory;
+        std::size_t _mappedSize; //0 when _memory comes from the heap
+        std::size_t _capacity;
+        std::size_t _used;
+        HugePages _hugePages;
+};
+
+/* Allocator of the BufferFloat: from the arena it was given, or on its own (zeroed, aligned) without one,
+ * or once the arena is full.
+ * As the memory comes zeroed, resize(n) does not write the new elements: they are zero, unless the
+ * buffer shrank and grew again, in which case they hold their former values. Copies of a buffer
+ * are always allocated on their own, so that they can outlive the arena. */
+template <typename T>
+class FieldAllocator
+{
+    public:
+        typedef T value_type;
+        /* A buffer moved into another one keeps its memory, wherever it is */
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        FieldAllocator():
+                    _arena(nullptr)
+        {
+        }
+
+        explicit FieldAllocator (FieldArena* arena):
+                    _arena(arena)
+        {
+        }
+
+        template <typename U>
+        FieldAllocator (FieldAllocator<U> const& other):
+                    _arena(other.getArena())
+        {
+        }
+
+        T* allocate (std::size_t n)
+        {
+            void* memory = (_arena != nullptr) ? _arena->allocate(n * sizeof(T)) : nullptr;
+            if (memory == nullptr) {
+                memory = FieldArena::allocateStandalone(n * sizeof(T));
+            }
+            return static_cast<T*>(memory);
+        }
+
+        void deallocate (T* p, std::size_t)
+        {
+            if (_arena == nullptr || !_arena->contains(p)) {
+                FieldArena::freeStandalone(p);
+            }
+        }
+
+        /* Default initialisation, which leaves floats untouched */
+        template <typename U>
+        void construct (U* p)
+        {
+            ::new(static_cast<void*>(p)) U;
+        }
+
+        template <typename U, typename... Args>
+        void construct (U* p, Args&&... args)
+        {
+            ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+        }
+
+        FieldAllocator select_on_container_copy_construction() const
+        {
+            return FieldAllocator();
+        }
+
+        FieldArena* getArena() const
+        {
+            return _arena;
+        }
+
+    private:
+        FieldArena* _arena;
+};
+
+template <typename T, typename U>
+bool operator== (FieldAllocator<T> const& a, FieldAllocator<U> const& b)
+{
+    return a.getArena() == b.getArena();
+}
+
+template <typename T, typename U>
+bool operator!= (FieldAllocator<T> const& a, FieldAllocator<U> const& b)
+{
+    return !(a == b);
+}
+
+#endif // FIELDARENA_HPP_INCLUDED
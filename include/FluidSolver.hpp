@@ -0,0 +1,294 @@
+#ifndef FLUIDSOLVER_HPP_INCLUDED
+#define FLUIDSOLVER_HPP_INCLUDED
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "FieldArena.hpp"
+#include "glm.hpp"
+
+
+typedef std::vector<float, FieldAllocator<float>> BufferFloat;
+typedef std::vector<bool> BufferBool;
+
+class ConjugateGradient;
+class GaussSeidel;
+class Multigrid;
+class SpectralPoisson;
+
+/* Methods available for the linear systems of diffuse() and project() */
+enum class LinearSolver
+{
+    GAUSS_SEIDEL, //relaxation sweeps, until the residual is small enough or the sweeps cap is reached
+    MULTIGRID, //V-cycles
+    FULL_MULTIGRID, //first guess from the coarse levels, then V-cycles
+    CONJUGATE_GRADIENT, //preconditioned, until the residual is small enough
+    SPECTRAL //exact, by cosine transform, any grid size. Falls back to Gauss-Seidel when the boundaries are not
+             //a plain copy (velocity diffusion), whose sweeps then count in the stats
+};
+
+enum class Preconditioner
+{
+    JACOBI, //cheap, inverse of the diagonal
+    MIC //modified incomplete Cholesky, MIC(0)
+};
+
+/* Order in which Gauss-Seidel relaxes the cells */
+enum class SweepOrdering
+{
+    LEXICOGRAPHIC, //line by line, sequential
+    RED_BLACK //checkerboard: all the cells of one colour only depend on the other colour, multithreaded
+};
+
+/* Parameters of the Gauss-Seidel solves */
+struct RelaxationSettings
+{
+    SweepOrdering ordering;
+    float tolerance; //relative residual stopping the sweeps, 0 to always do maxSweeps
+    unsigned int checkInterval; //sweeps between two measures of the residual
+    unsigned int maxSweeps;
+    unsigned int sweepsPerPass; //lexicographic sweeps done in a single pass over the grid
+};
+
+/* Outcome of a linear solve */
+struct SolveStats
+{
+    unsigned int iterations;
+    float residual; //relative to the right-hand side
+};
+
+/* Distance, in cells, between the starts of two lines of the fields */
+enum class RowPitch
+{
+    DENSE, //nbCols: each line right after the previous one (default)
+    PADDED //getPaddedPitch(nbCols)
+};
+
+/* Rounded up to whole cache lines, so that every line starts aligned for the SIMD kernels, plus one more
+ * cache line when that is a multiple of 128 floats: lines 512 bytes apart (or a multiple of that, as with
+ * power-of-two grids) put the cells of a column in the same few cache sets, and the stencils reading
+ * three lines of several fields evict each other. */
+constexpr unsigned int getPaddedPitch (unsigned int nbCols)
+{
+    return ((nbCols + 15) / 16 * 16) % 128 == 0 ? (nbCols + 15) / 16 * 16 + 16 : (nbCols + 15) / 16 * 16;
+}
+
+/* Size of the kernels specialised for this grid, 0 if it has none. The square grids of 128, 256, 512 and
+ * 1024 cells, dense or padded to getPaddedPitch, have kernels whose strides and trip counts are constants. */
+unsigned int getFixedSize (unsigned int nbCols, unsigned int nbLines, unsigned int pitch);
+
+/* Dimension (or pitch) of the grid: N when the kernel is specialised for a fixed size, the runtime value when N is 0 */
+template <unsigned int N>
+inline unsigned int dimension (unsigned int runtimeValue)
+{
+    return (N != 0) ? N : runtimeValue;
+}
+
+/* Numerical core of the simulation (Stam's stable fluids).
+ * It has no OpenGL nor SFML dependency, so it can run on machines without any display. */
+class FluidSolver
+{
+    public:
+        /* The fields are allocated together in a single arena, see FieldArena.hpp */
+        FluidSolver (unsigned int nbCols, unsigned int nbLines, float viscosity,
+                     HugePages hugePages=HugePages::TRANSPARENT, RowPitch rowPitch=RowPitch::DENSE);
+        ~FluidSolver();
+
+        unsigned int getNbCols() const;
+        unsigned int getNbLines() const;
+        /* Distance between two lines of the fields, nbCols or more. The cells past nbCols are padding:
+         * no kernel reads nor writes them, so they stay 0. */
+        unsigned int getPitch() const;
+        /* Pages the fields actually got */
+        HugePages getHugePages() const;
+
+        void reset();
+
+        /* position normalisée */
+        void addDensity (glm::vec2 pos, float radius, float strength=0.1f);
+        void addVelocity (glm::vec2 pos, glm::vec2 dir);
+
+        /* Passive scalars (dye, temperature, concentration...), carried like the density: they are
+         * diffused with the viscosity and advected by the velocity in the same sweeps as the density,
+         * so each of them costs much less than a separate field would. addScalar() returns the index
+         * of the new scalar, which starts at 0 everywhere. */
+        unsigned int addScalar();
+        unsigned int getNbScalars() const;
+        void addScalarSource (unsigned int scalar, glm::vec2 pos, float radius, float strength);
+
+        void update(float dt);
+
+        /* Overwrites the current state, e.g. with synthetic fields. Buffers hold getPitch()*nbLines values,
+         * laid out as the fields (see index()). */
+        void setState (BufferFloat const& densities, BufferFloat const& velX, BufferFloat const& velY);
+
+        /* Single phases of update(), for the benchmarks. Each one works on the current state and
+         * leaves its result there, without the rest of the update. */
+        void diffuseDensity (float dt);
+        void advectDensity (float dt);
+        /* Self-advection of both components of the velocity, in a single sweep */
+        void advectVelocity (float dt);
+        void projectVelocity();
+        void applyBoundaries();
+
+        void setViscosity (float viscosity);
+        float getViscosity() const;
+
+        void setPressureSolver (LinearSolver solver);
+        void setDiffusionSolver (LinearSolver solver);
+        LinearSolver getPressureSolver() const;
+        LinearSolver getDiffusionSolver() const;
+
+        /* Number of V-cycles per solve when using multigrid */
+        void setMultigridCycles (unsigned int nbCycles);
+
+        /* Stopping criteria of the conjugate gradient: relative residual and iterations cap */
+        void setPreconditioner (Preconditioner preconditioner);
+        void setTolerance (float tolerance);
+        void setMaxIterations (unsigned int maxIterations);
+
+        /* Stopping criteria of Gauss-Seidel. The residual is measured every checkInterval sweeps;
+         * a tolerance of 0 (default) always does maxSweeps (default 20). */
+        void setRelaxationTolerance (float tolerance);
+        void setRelaxationCheckInterval (unsigned int checkInterval);
+        void setRelaxationMaxSweeps (unsigned int maxSweeps);
+        void setRelaxationOrdering (SweepOrdering ordering);
+
+        /* Temporal blocking of the lexicographic sweeps: up to sweepsPerPass sweeps are done in a
+         * single pass over the grid, each one following the previous one a line behind, so the
+         * lines stay in cache from one sweep to the next. Same results whatever the value. */
+        void setRelaxationBlocking (unsigned int sweepsPerPass);
+
+        /* When enabled, each projection starts from the pressure it found at the previous update
+         * instead of 0. Disabled by default. */
+        void setWarmStart (bool warmStart);
+        bool getWarmStart() const;
+
+        /* The two components of the velocity are always advected in a single sweep. When enabled,
+         * the density is advected in that same sweep, hence by the diffused and projected velocity
+         * instead of the velocity of the start of the update. Disabled by default. */
+        void setFusedDensityAdvection (bool fused);
+        bool getFusedDensityAdvection() const;
+
+        /* Threads of the parallel kernels (red-black sweeps, spectral solves) during update() and
+         * the single phases. 0 (default) keeps the OpenMP default: OMP_NUM_THREADS, or all the cores. */
+        void setNbThreads (unsigned int nbThreads);
+        unsigned int getNbThreads() const;
+
+        /* Iterations (Gauss-Seidel sweeps or conjugate gradient iterations) done by the pressure
+         * and diffusion solves of the last update, and the largest relative residual they ended with.
+         * Multigrid and spectral solves are not counted. */
+        SolveStats const& getPressureStats() const;
+        SolveStats const& getDiffusionStats() const;
+
+        /* Current state of the fields, stored line by line, getPitch() cells apart */
+        BufferFloat const& getDensities() const;
+        BufferFloat const& getVelX() const;
+        BufferFloat const& getVelY() const;
+        BufferFloat const& getScalar (unsigned int scalar) const;
+
+        inline unsigned int index(unsigned int line, unsigned int col) const
+        {
+            return line*_pitch + col;
+        }
+
+    private:
+        /* pitch*nbLines zeroes, in the arena while it has room */
+        void allocateField (BufferFloat& buffer);
+
+        void solveDensity(float dt);
+        void solveVelocity(float dt);
+
+        /* Boundaries is the policy of the diffused field (see Boundaries.hpp) */
+        template <class Boundaries>
+        void diffuse(BufferFloat const& src, BufferFloat& dst, float dt);
+
+        /* diffuse() for several fields, in the same sweeps when using Gauss-Seidel */
+        template <class Boundaries>
+        void diffuseFields(std::vector<BufferFloat*> const& srcs, std::vector<BufferFloat*> const& dsts, float dt);
+
+        /* The density and the passive scalars: their current state and their scratch buffers */
+        void getTransportedFields (std::vector<BufferFloat*>& current, std::vector<BufferFloat*>& scratch);
+
+        /* Makes the vector field (velX, velY) an incompressible field.
+         * p holds the first guess of the pressure when warm starting, div is scratch memory. */
+        void project(BufferFloat& velX, BufferFloat& velY, BufferFloat& p, BufferFloat& div);
+
+        /* projectFixedSize for a SIZE x SIZE grid, with the kernels of its pitch */
+        template <unsigned int SIZE>
+        void projectSquare (BufferFloat& velX, BufferFloat& velY, BufferFloat& p, BufferFloat& div);
+
+        /* COLS, LINES and PITCH are the dimensions and the pitch of the grid, or 0 for the kernels
+         * working with any size */
+        template <unsigned int COLS, unsigned int LINES, unsigned int PITCH>
+        void projectFixedSize (BufferFloat& velX, BufferFloat& velY, BufferFloat& p, BufferFloat& div);
+
+        /* Pressure buffer of one of the two projections of solveVelocity(): persistent when warm
+         * starting, scratch otherwise */
+        BufferFloat& pressureBuffer (unsigned int iProjection, BufferFloat& scratch);
+
+        /* Adds the outcome of a solve to the statistics of the update */
+        void accumulate (SolveStats& total, SolveStats const& stats) const;
+
+        GaussSeidel& getGaussSeidel();
+        Multigrid& getMultigrid();
+        ConjugateGradient& getConjugateGradient();
+        SpectralPoisson& getSpectralPoisson();
+
+        /* The spectral solver needs Neumann boundaries and transformable grid dimensions */
+        bool canSolveSpectrally (float hFactor, float vFactor) const;
+
+        /* Makes sure boundary conditions are respected. */
+        template <class Boundaries>
+        void boundaryConditions (BufferFloat& buffer);
+        void densityBoundaryConditions (BufferFloat& densities);
+        void velXBoundaryConditions (BufferFloat& velX);
+        void velYBoundaryConditions (BufferFloat& velY);
+
+
+    private:
+        const unsigned int _nbLines;
+        const unsigned int _nbCols;
+        const unsigned int _pitch;
+
+        std::unique_ptr<FieldArena> _arena; //declared first, so that the fields are freed before it
+
+        unsigned int _currDensity; //0 or 1
+        std::array<BufferFloat, 2> _densities;
+
+        std::vector<std::array<BufferFloat, 2>> _scalars; //current state, then scratch buffer
+
+        unsigned int _currVel; //0 or 1
+        std::array<BufferFloat, 2> _velX;
+        std::array<BufferFloat, 2> _velY;
+
+        LinearSolver _pressureSolver;
+        LinearSolver _diffusionSolver;
+        SolveStats _pressureStats;
+        SolveStats _diffusionStats;
+
+        bool _warmStart;
+        std::array<BufferFloat, 2> _pressures; //allocated when warm starting
+
+        bool _fusedDensityAdvection;
+
+        unsigned int _nbThreads; //0 for the OpenMP default
+
+        RelaxationSettings _relaxation;
+        std::unique_ptr<GaussSeidel> _gaussSeidel; //built on first use
+
+        unsigned int _multigridCycles;
+        std::unique_ptr<Multigrid> _multigrid; //built on first use
+
+        Preconditioner _preconditioner;
+        float _tolerance;
+        unsigned int _maxIterations;
+        std::unique_ptr<ConjugateGradient> _conjugateGradient; //built on first use
+
+        std::unique_ptr<SpectralPoisson> _spectralPoisson; //built on first use
+
+        float _viscosity;
+};
+
+#endif // FLUIDSOLVER_HPP_INCLUDED
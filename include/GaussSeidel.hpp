@@ -0,0 +1,83 @@
+#ifndef GAUSSSEIDEL_HPP_INCLUDED
+#define GAUSSSEIDEL_HPP_INCLUDED
+
+#include <vector>
+
+#include "FluidSolver.hpp"
+
+
+/* Gauss-Seidel relaxation for the 5-point systems of the simulation:
+ *     diag*x - coupling*(sum of the 4 neighbours of x) = rhs
+ * on the interior of the grid, its outer ring following the Boundaries policy (see Boundaries.hpp),
+ * which is applied to each line as soon as a sweep is done with it. */
+class GaussSeidel
+{
+    public:
+        /* Lines of the buffers are pitch cells apart */
+        GaussSeidel (unsigned int nbCols, unsigned int nbLines, unsigned int pitch);
+
+        /* Sweeps until the residual is below settings.tolerance * |rhs| (2-norm) or settings.maxSweeps
+         * have been done. The residual is only measured every settings.checkInterval sweeps (and on the
+         * last one), during the sweep itself: each cell is updated by residual/diag, so it comes almost
+         * for free. With a tolerance of 0, exactly maxSweeps are done.
+         * Instantiated for the policies of Boundaries.hpp, with kernels specialised for the most
+         * common grid sizes (square 128, 256, 512 and 1024, dense or padded to getPaddedPitch). */
+        template <class Boundaries>
+        SolveStats solve (BufferFloat& x, BufferFloat const& rhs, float diag, float coupling,
+                          RelaxationSettings const& settings);
+
+        /* Same system for several fields (x[i], rhs[i]), solved in the same sweeps: each line is relaxed
+         * in every field before moving on, and the stopping criterion is on the residual of all of them. */
+        template <class Boundaries>
+        SolveStats solve (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                          float diag, float coupling, RelaxationSettings const& settings);
+
+    private:
+        /* solveFixedSize for a SIZE x SIZE grid, with the kernels of its pitch */
+        template <class Boundaries, unsigned int SIZE>
+        void solveSquare (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                          float diag, float coupling, RelaxationSettings const& settings, SolveStats& stats);
+
+        /* COLS, LINES and PITCH are the dimensions and the pitch of the grid, or 0 for the kernels
+         * working with any size */
+        template <class Boundaries, unsigned int COLS, unsigned int LINES, unsigned int PITCH>
+        void solveFixedSize (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                             float diag, float coupling, RelaxationSettings const& settings, SolveStats& stats);
+
+        /* Whether sweep number `sweep` (starting at 1) measures the residual */
+        bool isChecked (unsigned int sweep, RelaxationSettings const& settings) const;
+
+        /* Sweeps per pass of temporal blocking, so that the lines being relaxed stay in cache */
+        unsigned int getMaxSweepsPerPass (unsigned int sweepsPerPass, unsigned int nbFields) const;
+
+        template <class Boundaries, unsigned int COLS, unsigned int LINES, unsigned int PITCH>
+        void solveLexicographic (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                                 float diag, float coupling, RelaxationSettings const& settings,
+                                 SolveStats& stats) const;
+
+        /* nbSweeps lexicographic sweeps in a single pass over the grid (wavefront).
+         * When MEASURE is set, returns the squared 2-norm of the residual met by the last sweep. */
+        template <class Boundaries, bool MEASURE, unsigned int COLS, unsigned int LINES, unsigned int PITCH>
+        double relaxPass (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                          float diag, float coupling, unsigned int nbSweeps) const;
+
+        /* All the sweeps are done in a single parallel region. Lines are shared between the threads,
+         * and each colour ends with the only barrier of its half-sweep: the outer ring is updated line
+         * by line during the black half-sweep, by the thread which relaxed the line. */
+        template <class Boundaries, unsigned int COLS, unsigned int LINES, unsigned int PITCH>
+        void solveRedBlack (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                            float diag, float coupling, RelaxationSettings const& settings, SolveStats& stats);
+
+        /* Squared 2-norm of the interior of all the fields */
+        double norm2 (BufferFloat const* const* buffers, unsigned int nbFields) const;
+
+
+    private:
+        const unsigned int _nbCols;
+        const unsigned int _nbLines;
+        const unsigned int _pitch;
+
+        std::vector<double> _partialResiduals; //one per thread, for the red-black sweeps
+};
+
+#endif // GAUSSSEIDEL_HPP_INCLUDED
@@ -0,0 +1,114 @@
+#ifndef MULTIGRID_HPP_INCLUDED
+#define MULTIGRID_HPP_INCLUDED
+
+#include <array>
+#include <vector>
+
+#include "FluidSolver.hpp"
+
+
+/* Geometric multigrid solver for the 5-point systems of the simulation:
+ *     diag*x - coupling*(sum of the 4 neighbours of x) = rhs
+ * on the interior of the grid, its outer ring following applyBoundaryConditions.
+ * project() uses it with (4, 1) for the pressure and diffuse() with (1+4a, a).
+ *
+ * Each level halves the number of interior cells in both directions (rounding up, so the
+ * last cell of a level may only cover one finer cell). Residuals are restricted by
+ * area-weighted averaging and corrections are prolongated bilinearly. Coarse operators
+ * are the Galerkin products restriction.A.prolongation: 9-point stencils which stay
+ * consistent whatever the parity of the grid sizes. All levels are smoothed with
+ * Gauss-Seidel and the coarsest one is small enough to be solved by relaxation. */
+class Multigrid
+{
+    public:
+        /* Lines of the buffers given to solve() are pitch cells apart */
+        Multigrid (unsigned int nbCols, unsigned int nbLines, unsigned int pitch);
+
+        unsigned int getNbLevels() const;
+
+        /* Improves x, which must already hold a valid first guess (and valid boundaries).
+         * With fullMultigrid, x is discarded and the first guess is built from the coarse levels. */
+        void solve (BufferFloat& x, BufferFloat const& rhs, float diag, float coupling,
+                    float hFactor, float vFactor, unsigned int nbCycles, bool fullMultigrid=false);
+
+    private:
+        typedef std::array<BufferFloat, 9> Stencil; //coefficient (dLine+1)*3 + (dCol+1) of each cell
+
+        struct Level
+        {
+            unsigned int nbCols;
+            unsigned int nbLines;
+            unsigned int pitch; //the one of the solved buffers for the finest level, nbCols for the others
+
+            /* Size of the cells, in finest cells. The outer ring has no area. */
+            std::vector<float> colAreas;
+            std::vector<float> lineAreas;
+
+            BufferFloat x; //unused for the finest level
+            BufferFloat rhs; //unused for the finest level
+            BufferFloat residual;
+
+            Stencil stencil; //operator of the current system, unused for the finest level
+        };
+
+        /* Coarse operators for one pair of boundary factors. Since the finest operator is
+         * identity*I + coupling*(4I - neighbours), each coarse one is the same combination
+         * of the Galerkin products of I and of the Laplacian, which are computed once. */
+        struct Operators
+        {
+            float hFactor;
+            float vFactor;
+
+            std::vector<Stencil> identity; //[iLevel-1]
+            std::vector<Stencil> laplacian; //[iLevel-1]
+        };
+
+        /* Finds or builds the coarse operators for the current boundary factors */
+        Operators const& getOperators();
+
+        /* Galerkin product of an operator of level iLevel-1, probed with 9 interleaved sets
+         * of coarse cells: any 3x3 neighbourhood contains exactly one cell of each set. */
+        void buildCoarseStencil (unsigned int iLevel, Stencil const* fineStencil, bool identity, Stencil& coarseStencil);
+
+        /* y = A.x on the interior of a level. A is fineStencil if given, otherwise the identity
+         * or the Laplacian of the finest level (which reads the outer ring of x). */
+        void applyOperator (unsigned int iLevel, Stencil const* stencil, bool identity,
+                            BufferFloat const& x, BufferFloat& y) const;
+
+        void vCycle (unsigned int iLevel, BufferFloat& x, BufferFloat const& rhs);
+
+        void smooth (unsigned int iLevel, BufferFloat& x, BufferFloat const& rhs, unsigned int nbSweeps);
+        void computeResidual (unsigned int iLevel, BufferFloat const& x, BufferFloat const& rhs);
+
+        /* With pure Neumann boundaries and no identity term (pressure), the system is singular
+         * and only has a solution if the area-weighted sum of the rhs is zero. Coarse levels
+         * are made to comply, otherwise their relaxation drifts. */
+        void makeCompatible (Level const& level, BufferFloat& rhs);
+
+        /* fine -> coarse, area-weighted average of the fine cells */
+        void restrict (Level const& fine, BufferFloat const& fineBuffer, Level const& coarse, BufferFloat& coarseBuffer) const;
+
+        /* coarse -> fine, bilinear interpolation added to (or replacing) the fine buffer.
+         * The boundaries of the coarse buffer are updated first. */
+        void prolongate (Level const& coarse, BufferFloat& coarseBuffer, Level const& fine, BufferFloat& fineBuffer,
+                         bool add) const;
+
+
+    private:
+        std::vector<Level> _levels;
+
+        std::vector<Operators> _operators;
+        Operators const* _currentOperators;
+
+        float _identity;
+        float _coupling;
+        float _hFactor;
+        float _vFactor;
+        bool _singular;
+
+        unsigned int _nbPreSmooth;
+        unsigned int _nbPostSmooth;
+        unsigned int _nbCoarsestSweeps;
+};
+
+#endif // MULTIGRID_HPP_INCLUDED
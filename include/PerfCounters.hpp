@@ -0,0 +1,41 @@
+#ifndef PERFCOUNTERS_HPP_INCLUDED
+#define PERFCOUNTERS_HPP_INCLUDED
+
+#include <cstdint>
+
+
+/* Hardware performance counters of the calling thread, read through Linux perf_event_open.
+ * The Profiler reads them around each timed scope once they are opened, so they give the cost
+ * of each phase in cycles, instructions and misses. Work done by the other OpenMP threads is not
+ * counted: run with OMP_NUM_THREADS=1 for complete figures.
+ * Opening fails on other systems, in virtual machines without a PMU, or when
+ * /proc/sys/kernel/perf_event_paranoid forbids it; the simulation then runs as usual. */
+class PerfCounters
+{
+    public:
+        struct Values
+        {
+            std::uint64_t cycles;
+            std::uint64_t instructions;
+            std::uint64_t llcMisses; //last level cache
+            std::uint64_t branchMisses;
+        };
+
+        /* Opens and starts the counters for the calling thread. Returns false if they are not available. */
+        static bool open();
+        static void close();
+
+        static bool isOpen()
+        {
+            return _groupFd >= 0;
+        }
+
+        /* Counts since open(), all 0 when not open */
+        static Values read();
+
+    private:
+        static int _groupFd; //leader of the group, -1 when closed
+        static int _fds[4];
+};
+
+#endif // PERFCOUNTERS_HPP_INCLUDED
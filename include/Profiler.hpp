@@ -0,0 +1,129 @@
+#ifndef PROFILER_HPP_INCLUDED
+#define PROFILER_HPP_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "PerfCounters.hpp"
+
+
+/* Scoped timers around the phases of the simulation, enabled by building with -DPROFILING
+ * (make PROFILE=1). Otherwise PROFILE_SCOPE expands to nothing and no phase is ever recorded.
+ *
+ *     void FluidSolver::project (...)
+ *     {
+ *         PROFILE_SCOPE("project");
+ *
+ * Each phase keeps a histogram of its durations, with 16 buckets per power of 2 (about 4% wide),
+ * from which the percentiles are read. Phases are meant to be timed from the main thread:
+ * recording is not synchronised (TRACE_SCOPE, see Tracer.hpp, is the one for parallel regions).
+ * Timed scopes also go to the Tracer when it records, and read the hardware counters once they are
+ * opened (see PerfCounters.hpp). PROFILE_SCOPE_CELLS gives the number of cells a phase works on,
+ * so that its counters can be reported per cell. */
+class ProfilePhase
+{
+    public:
+        explicit ProfilePhase (std::string const& name);
+
+        std::string const& getName() const;
+
+        void record (std::uint64_t nanoseconds);
+        /* Counters spent by one call working on `cells` cells (0 if unknown) */
+        void recordCounters (PerfCounters::Values const& counters, std::uint64_t cells);
+        void reset();
+
+        std::uint64_t getCount() const;
+        double getTotal() const; //all the durations below are in milliseconds
+        double getMin() const;
+        double getMax() const;
+        double getMean() const;
+        /* Upper bound of the histogram bucket holding the given fraction of the durations */
+        double getPercentile (double fraction) const;
+
+        /* Hardware counters, summed over the calls which read them */
+        bool hasCounters() const;
+        PerfCounters::Values const& getCounters() const;
+        double getInstructionsPerCycle() const;
+        /* 0 when the number of cells is unknown */
+        double getPerCell (std::uint64_t count) const;
+        /* Memory traffic estimated from the last level cache misses (one line each) */
+        double getBytesPerCell() const;
+
+    private:
+        static const unsigned int SUB_BUCKETS = 16; //per power of 2
+        static const unsigned int NB_BUCKETS = 64 * SUB_BUCKETS;
+
+        static unsigned int getBucket (std::uint64_t nanoseconds);
+        static double getBucketUpperBound (unsigned int bucket); //nanoseconds
+
+
+    private:
+        const std::string _name;
+
+        std::uint64_t _count;
+        std::uint64_t _total;
+        std::uint64_t _min;
+        std::uint64_t _max;
+        std::vector<std::uint64_t> _histogram;
+
+        std::uint64_t _countedCalls;
+        PerfCounters::Values _counters;
+        std::uint64_t _countedCells;
+};
+
+class Profiler
+{
+    public:
+        /* Finds or creates the phase with that name. References stay valid until the end of the program. */
+        static ProfilePhase& getPhase (std::string const& name);
+
+        /* Phases in the order they were first met */
+        static std::vector<ProfilePhase const*> getPhases();
+
+        static void reset();
+
+        /* One line per phase: name, count, total, min, mean, p99 and max (in milliseconds), then
+         * when the hardware counters were read: IPC, and LLC misses, bytes and branch misses per cell */
+        static void writeCsv (std::ostream& stream);
+
+        /* Short text for a HUD: one line per phase with its mean and p99, and its IPC and bytes
+         * per cell when the hardware counters were read */
+        static std::string getSummary();
+};
+
+/* Records the time spent between its construction and its destruction */
+class ScopedTimer
+{
+    public:
+        explicit ScopedTimer (ProfilePhase& phase, std::uint64_t cells=0);
+        ~ScopedTimer();
+
+        ScopedTimer (ScopedTimer const&) = delete;
+        ScopedTimer& operator= (ScopedTimer const&) = delete;
+
+    private:
+        ProfilePhase& _phase;
+        const std::uint64_t _cells;
+        const bool _counting;
+        const PerfCounters::Values _startCounters;
+        const std::chrono::steady_clock::time_point _start;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef PROFILING
+/* The phase is looked up once per call site (and per template instantiation) */
+#define PROFILE_SCOPE_CELLS(name, cells) \
+    static ProfilePhase& PROFILE_CONCAT(profilePhase, __LINE__) = Profiler::getPhase(name); \
+    const ScopedTimer PROFILE_CONCAT(profileTimer, __LINE__)(PROFILE_CONCAT(profilePhase, __LINE__), cells)
+#else
+#define PROFILE_SCOPE_CELLS(name, cells)
+#endif
+
+#define PROFILE_SCOPE(name) PROFILE_SCOPE_CELLS(name, 0)
+
+#endif // PROFILER_HPP_INCLUDED
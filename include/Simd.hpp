@@ -0,0 +1,143 @@
+#ifndef SIMD_HPP_INCLUDED
+#define SIMD_HPP_INCLUDED
+
+/* Thin wrappers over the vector instructions the solver is compiled for (SIMD variable of the
+ * Makefile): AVX-512, AVX2 with FMA, or none. SIMD_ENABLED is only defined in the first two cases,
+ * otherwise the kernels keep to their scalar loops. Loads and stores are unaligned, except for
+ * loadAligned (and stream) whose address must be a multiple of the vector size. */
+
+#include <cstddef>
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+#define SIMD_ENABLED
+
+namespace simd
+{
+    typedef __m512 Floats;
+    typedef __mmask16 Mask;
+
+    static const unsigned int WIDTH = 16;
+
+    inline Floats load (float const* p) { return _mm512_loadu_ps(p); }
+    inline Floats loadAligned (float const* p) { return _mm512_load_ps(p); }
+    inline void store (float* p, Floats a) { _mm512_storeu_ps(p, a); }
+    inline Floats set (float f) { return _mm512_set1_ps(f); }
+
+    /* 0, 1, 2... */
+    inline Floats iota() { return _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); }
+
+    inline Floats add (Floats a, Floats b) { return _mm512_add_ps(a, b); }
+    inline Floats sub (Floats a, Floats b) { return _mm512_sub_ps(a, b); }
+    inline Floats mul (Floats a, Floats b) { return _mm512_mul_ps(a, b); }
+    inline Floats fmadd (Floats a, Floats b, Floats c) { return _mm512_fmadd_ps(a, b, c); } //a*b + c
+    /* The unmasked forms of the conversions, min, max and gather trigger -Wuninitialized with GCC 12 */
+    inline Floats min (Floats a, Floats b) { return _mm512_maskz_min_ps(0xFFFF, a, b); }
+    inline Floats max (Floats a, Floats b) { return _mm512_maskz_max_ps(0xFFFF, a, b); }
+
+    typedef __m512i Ints;
+
+    inline Ints setInt (int i) { return _mm512_set1_epi32(i); }
+    inline Ints addInt (Ints a, Ints b) { return _mm512_add_epi32(a, b); }
+    inline Ints mulInt (Ints a, Ints b) { return _mm512_mullo_epi32(a, b); }
+    inline Ints truncate (Floats a) { return _mm512_maskz_cvttps_epi32(0xFFFF, a); }
+    inline Floats toFloats (Ints a) { return _mm512_maskz_cvtepi32_ps(0xFFFF, a); }
+
+    /* base[indices] */
+    inline Floats gather (float const* base, Ints indices) { return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, indices, base, 4); }
+
+    /* Non-temporal store, p must be aligned on a whole vector. fence() orders them with later stores. */
+    inline bool isAligned (float const* p) { return reinterpret_cast<std::size_t>(p) % 64 == 0; }
+    inline void stream (float* p, Floats a) { _mm512_stream_ps(p, a); }
+    inline void fence() { _mm_sfence(); }
+
+    /* Lanes 0, 2, 4... (parity 0) or 1, 3, 5... (parity 1) */
+    inline Mask alternate (unsigned int parity) { return (parity == 0) ? 0x5555 : 0xAAAA; }
+    inline Mask withoutFirstLane (Mask mask) { return mask & 0xFFFE; }
+    /* b where mask is set, a elsewhere */
+    inline Floats select (Mask mask, Floats a, Floats b) { return _mm512_mask_blend_ps(mask, a, b); }
+    /* Only the lanes where mask is set are read (0 elsewhere) or written: the others are not accessed */
+    inline Floats maskLoad (Mask mask, float const* p) { return _mm512_maskz_loadu_ps(mask, p); }
+    inline void maskStore (float* p, Mask mask, Floats a) { _mm512_mask_storeu_ps(p, mask, a); }
+
+    inline float sum (Floats a)
+    {
+        /* _mm512_reduce_add_ps and the unmasked shuffles trigger -Wuninitialized with GCC 12 */
+        a = _mm512_add_ps(a, _mm512_maskz_shuffle_f32x4(0xFFFF, a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+        a = _mm512_add_ps(a, _mm512_maskz_shuffle_f32x4(0xFFFF, a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128 quarter = _mm512_maskz_extractf32x4_ps(0xF, a, 0);
+        quarter = _mm_add_ps(quarter, _mm_movehl_ps(quarter, quarter));
+        quarter = _mm_add_ss(quarter, _mm_movehdup_ps(quarter));
+        return _mm_cvtss_f32(quarter);
+    }
+}
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+#include <immintrin.h>
+#define SIMD_ENABLED
+
+namespace simd
+{
+    typedef __m256 Floats;
+    typedef __m256 Mask;
+
+    static const unsigned int WIDTH = 8;
+
+    inline Floats load (float const* p) { return _mm256_loadu_ps(p); }
+    inline Floats loadAligned (float const* p) { return _mm256_load_ps(p); }
+    inline void store (float* p, Floats a) { _mm256_storeu_ps(p, a); }
+    inline Floats set (float f) { return _mm256_set1_ps(f); }
+
+    /* 0, 1, 2... */
+    inline Floats iota() { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+
+    inline Floats add (Floats a, Floats b) { return _mm256_add_ps(a, b); }
+    inline Floats sub (Floats a, Floats b) { return _mm256_sub_ps(a, b); }
+    inline Floats mul (Floats a, Floats b) { return _mm256_mul_ps(a, b); }
+    inline Floats fmadd (Floats a, Floats b, Floats c) { return _mm256_fmadd_ps(a, b, c); } //a*b + c
+    inline Floats min (Floats a, Floats b) { return _mm256_min_ps(a, b); }
+    inline Floats max (Floats a, Floats b) { return _mm256_max_ps(a, b); }
+
+    typedef __m256i Ints;
+
+    inline Ints setInt (int i) { return _mm256_set1_epi32(i); }
+    inline Ints addInt (Ints a, Ints b) { return _mm256_add_epi32(a, b); }
+    inline Ints mulInt (Ints a, Ints b) { return _mm256_mullo_epi32(a, b); }
+    inline Ints truncate (Floats a) { return _mm256_cvttps_epi32(a); }
+    inline Floats toFloats (Ints a) { return _mm256_cvtepi32_ps(a); }
+
+    /* base[indices] */
+    inline Floats gather (float const* base, Ints indices) { return _mm256_i32gather_ps(base, indices, 4); }
+
+    /* Non-temporal store, p must be aligned on a whole vector. fence() orders them with later stores. */
+    inline bool isAligned (float const* p) { return reinterpret_cast<std::size_t>(p) % 32 == 0; }
+    inline void stream (float* p, Floats a) { _mm256_stream_ps(p, a); }
+    inline void fence() { _mm_sfence(); }
+
+    /* Lanes 0, 2, 4... (parity 0) or 1, 3, 5... (parity 1) */
+    inline Mask alternate (unsigned int parity)
+    {
+        const int even = (parity == 0) ? -1 : 0, odd = ~even;
+        return _mm256_castsi256_ps(_mm256_setr_epi32(even, odd, even, odd, even, odd, even, odd));
+    }
+    inline Mask withoutFirstLane (Mask mask) { return _mm256_blend_ps(mask, _mm256_setzero_ps(), 0x1); }
+    /* b where mask is set, a elsewhere */
+    inline Floats select (Mask mask, Floats a, Floats b) { return _mm256_blendv_ps(a, b, mask); }
+    /* Only the lanes where mask is set are read (0 elsewhere) or written: the others are not accessed */
+    inline Floats maskLoad (Mask mask, float const* p) { return _mm256_maskload_ps(p, _mm256_castps_si256(mask)); }
+    inline void maskStore (float* p, Mask mask, Floats a) { _mm256_maskstore_ps(p, _mm256_castps_si256(mask), a); }
+
+    inline float sum (Floats a)
+    {
+        __m128 half = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+        half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+        half = _mm_add_ss(half, _mm_movehdup_ps(half));
+        return _mm_cvtss_f32(half);
+    }
+}
+
+#endif
+
+#endif // SIMD_HPP_INCLUDED
@@ -0,0 +1,54 @@
+#ifndef SPECTRALPOISSON_HPP_INCLUDED
+#define SPECTRALPOISSON_HPP_INCLUDED
+
+#include <vector>
+
+#include "Dct.hpp"
+#include "FluidSolver.hpp"
+
+
+/* Direct solver for the 5-point systems of the simulation:
+ *     diag*x - coupling*(sum of the 4 neighbours of x) = rhs
+ * when the outer ring is a plain copy of the interior (hFactor = vFactor = 1, no obstacle).
+ * The cosine transform diagonalises this operator, so the solve is exact and costs
+ * O(N log N): transform, divide by the eigenvalues, transform back.
+ * Rows and columns are transformed by blocks, in parallel. */
+class SpectralPoisson
+{
+    public:
+        /* Lines of the buffers are pitch cells apart */
+        SpectralPoisson (unsigned int nbCols, unsigned int nbLines, unsigned int pitch);
+
+        /* True if the grid has an interior to transform */
+        static bool isSupported (unsigned int nbCols, unsigned int nbLines);
+
+        /* Overwrites x, outer ring included. When the system is singular (diag = 4*coupling),
+         * the solution with zero mean is returned. */
+        void solve (BufferFloat& x, BufferFloat const& rhs, float diag, float coupling);
+
+    private:
+        /* Transforms along the lines (each column is a signal), then along the columns */
+        void transform (BufferFloat& x, bool inverse);
+
+        /* One workspace per thread of the coming parallel regions, whose number may have changed */
+        void allocateWorkspaces();
+        float* getWorkspace();
+
+
+    private:
+        const unsigned int _nbCols;
+        const unsigned int _nbLines;
+        const unsigned int _pitch;
+
+        Dct _lineTransform; //size nbLines-2
+        Dct _colTransform; //size nbCols-2
+
+        /* 2 - 2*cos(pi*k/n), eigenvalues of the 1D operator */
+        std::vector<float> _lineEigenvalues;
+        std::vector<float> _colEigenvalues;
+
+        std::size_t _workspaceSize;
+        std::vector<BufferFloat> _workspaces; //one per thread
+};
+
+#endif // SPECTRALPOISSON_HPP_INCLUDED
@@ -0,0 +1,66 @@
+#ifndef TRACER_HPP_INCLUDED
+#define TRACER_HPP_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+
+/* Timeline of the phases of the simulation, written in the Chrome trace format (chrome://tracing,
+ * ui.perfetto.dev). Like the Profiler, it only exists in builds with -DPROFILING: every PROFILE_SCOPE
+ * is traced as well, and TRACE_SCOPE traces without aggregating, which is safe inside parallel regions.
+ *
+ * Recording is off until start(). Each thread then writes its events into a ring buffer of its own,
+ * without any lock; when it is full, the oldest events are overwritten. */
+class Tracer
+{
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        /* Events kept per thread */
+        static const unsigned int CAPACITY = 1 << 16;
+
+        /* Forgets the previous events and starts recording */
+        static void start();
+        static void stop();
+
+        static bool isRecording()
+        {
+            return _recording.load(std::memory_order_relaxed);
+        }
+
+        /* name must stay valid until the trace is written (string literal, phase name) */
+        static void record (char const* name, Clock::time_point begin, Clock::time_point end);
+
+        /* To be called while no thread records, typically after stop() */
+        static void writeChromeTrace (std::ostream& stream);
+
+    private:
+        static std::atomic<bool> _recording;
+};
+
+/* Traces the time spent between its construction and its destruction */
+class TraceScope
+{
+    public:
+        explicit TraceScope (char const* name);
+        ~TraceScope();
+
+        TraceScope (TraceScope const&) = delete;
+        TraceScope& operator= (TraceScope const&) = delete;
+
+    private:
+        char const* const _name;
+        const Tracer::Clock::time_point _start;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef PROFILING
+#define TRACE_SCOPE(name) const TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
+
+#endif // TRACER_HPP_INCLUDED
@@ -4,6 +4,7 @@
 #include <sstream>
 
 #include "GLHelper.hpp"
+#include "Profiler.hpp"
 
 
 Fluid::Fluid(unsigned int nbCols, unsigned int nbLines, float viscosity):
@@ -91,6 +92,7 @@ sf::Vector2i Fluid::getSize() const
 
 void Fluid::draw(bool drawDensity, bool drawIntensity)
 {
+    PROFILE_SCOPE("draw");
 
     GLCHECK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
     GLCHECK(glClearColor(0, 0, 0, 1.0));
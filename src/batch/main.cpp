@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "FluidSolver.hpp"
+#include "PerfCounters.hpp"
+#include "Profiler.hpp"
+#include "Tracer.hpp"
+
+
+/* Headless simulation: no window, no vsync, only the solver is timed. */
+
+struct BatchSettings
+{
+    unsigned int nbCols;
+    unsigned int nbLines;
+    float viscosity;
+    float dt;
+    unsigned int steps;
+    LinearSolver pressureSolver;
+    LinearSolver diffusionSolver;
+    unsigned int multigridCycles;
+    Preconditioner preconditioner;
+    float tolerance;
+    unsigned int maxIterations;
+    float relaxationTolerance;
+    unsigned int checkInterval;
+    unsigned int maxSweeps;
+    SweepOrdering ordering;
+    unsigned int sweepsPerPass;
+    bool warmStart;
+    bool fusedDensityAdvection;
+    unsigned int nbScalars;
+    unsigned int nbThreads;
+    HugePages hugePages;
+    RowPitch rowPitch;
+    std::string profileFile;
+    std::string traceFile;
+    bool counters;
+};
+
+void printUsage (const char* exec);
+bool parseArguments (int argc, char *argv[], BatchSettings& settings);
+bool parseLinearSolver (std::string const& name, LinearSolver& solver);
+
+/* Iterations and residuals are only reported by Gauss-Seidel and the conjugate gradient */
+bool isIterative (LinearSolver solver);
+void printStats (std::string const& name, unsigned long iterations, float residual, unsigned int steps);
+/* IPC, LLC misses, bytes and branch misses per cell of each phase which read the hardware counters */
+void printCounters();
+
+/* Keeps injecting density and momentum in the middle of the domain, like a user would */
+void stir (FluidSolver& solver, unsigned int step);
+
+int main(int argc, char *argv[])
+{
+    BatchSettings settings;
+    settings.nbCols = 100;
+    settings.nbLines = 100;
+    settings.viscosity = 0.0001f;
+    settings.dt = 1.f / 60.f;
+    settings.steps = 1000;
+    settings.pressureSolver = LinearSolver::GAUSS_SEIDEL;
+    settings.diffusionSolver = LinearSolver::GAUSS_SEIDEL;
+    settings.multigridCycles = 2;
+    settings.preconditioner = Preconditioner::MIC;
+    settings.tolerance = 1e-3f;
+    settings.maxIterations = 200;
+    settings.relaxationTolerance = 0.f;
+    settings.checkInterval = 4;
+    settings.maxSweeps = 20;
+    settings.ordering = SweepOrdering::LEXICOGRAPHIC;
+    settings.sweepsPerPass = 8;
+    settings.warmStart = false;
+    settings.fusedDensityAdvection = false;
+    settings.nbScalars = 0;
+    settings.nbThreads = 0;
+    settings.hugePages = HugePages::TRANSPARENT;
+    settings.rowPitch = RowPitch::DENSE;
+    settings.counters = false;
+
+    if (!parseArguments(argc, argv, settings)) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FluidSolver solver(settings.nbCols, settings.nbLines, settings.viscosity, settings.hugePages, settings.rowPitch);
+    solver.setPressureSolver(settings.pressureSolver);
+    solver.setDiffusionSolver(settings.diffusionSolver);
+    solver.setMultigridCycles(settings.multigridCycles);
+    solver.setPreconditioner(settings.preconditioner);
+    solver.setTolerance(settings.tolerance);
+    solver.setMaxIterations(settings.maxIterations);
+    solver.setRelaxationTolerance(settings.relaxationTolerance);
+    solver.setRelaxationCheckInterval(settings.checkInterval);
+    solver.setRelaxationMaxSweeps(settings.maxSweeps);
+    solver.setRelaxationOrdering(settings.ordering);
+    solver.setRelaxationBlocking(settings.sweepsPerPass);
+    solver.setWarmStart(settings.warmStart);
+    solver.setFusedDensityAdvection(settings.fusedDensityAdvection);
+    solver.setNbThreads(settings.nbThreads);
+    for (unsigned int i = 0 ; i < settings.nbScalars ; ++i) {
+        solver.addScalar();
+    }
+
+    if (!settings.traceFile.empty()) {
+        Tracer::start();
+    }
+    if (settings.counters) {
+#ifdef PROFILING
+        if (!PerfCounters::open()) {
+            std::cerr << "Warning: hardware counters unavailable (no PMU, or see /proc/sys/kernel/perf_event_paranoid)." << std::endl;
+        }
+#else
+        std::cerr << "Warning: built without PROFILING (make PROFILE=1), no hardware counters." << std::endl;
+#endif
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+
+    unsigned long pressureIterations = 0, diffusionIterations = 0;
+    float pressureResidual = 0.f, diffusionResidual = 0.f;
+    for (unsigned int step = 0 ; step < settings.steps ; ++step) {
+        stir(solver, step);
+        solver.update(settings.dt);
+
+        pressureIterations += solver.getPressureStats().iterations;
+        pressureResidual = std::max(pressureResidual, solver.getPressureStats().residual);
+        diffusionIterations += solver.getDiffusionStats().iterations;
+        diffusionResidual = std::max(diffusionResidual, solver.getDiffusionStats().residual);
+    }
+
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    Tracer::stop();
+    PerfCounters::close();
+    const double cells = static_cast<double>(settings.nbCols) * static_cast<double>(settings.nbLines);
+
+    double mass = 0.0;
+    for (float density : solver.getDensities()) {
+        mass += density;
+    }
+
+    std::cout << "size: " << settings.nbCols << "x" << settings.nbLines << std::endl;
+    std::cout << "viscosity: " << settings.viscosity << std::endl;
+    std::cout << "dt: " << settings.dt << std::endl;
+    std::cout << "steps: " << settings.steps << std::endl;
+    std::cout << "total time: " << seconds << " s" << std::endl;
+    std::cout << "steps/second: " << static_cast<double>(settings.steps) / seconds << std::endl;
+    std::cout << "cells/second: " << cells * static_cast<double>(settings.steps) / seconds << std::endl;
+    std::cout << "final mass: " << mass << std::endl;
+    std::cout << "warm start: " << (settings.warmStart ? "yes" : "no") << std::endl;
+    std::cout << "fused density advection: " << (settings.fusedDensityAdvection ? "yes" : "no") << std::endl;
+    std::cout << "passive scalars: " << settings.nbScalars << std::endl;
+    std::cout << "huge pages: " << getHugePagesName(solver.getHugePages()) << std::endl;
+    std::cout << "pitch: " << solver.getPitch() << std::endl;
+    if (isIterative(settings.pressureSolver)) {
+        printStats("pressure", pressureIterations, pressureResidual, settings.steps);
+    }
+    if (isIterative(settings.diffusionSolver) || diffusionIterations > 0) { //spectral falling back to Gauss-Seidel
+        printStats("diffusion", diffusionIterations, diffusionResidual, settings.steps);
+    }
+    printCounters();
+
+    if (!settings.profileFile.empty()) {
+#ifdef PROFILING
+        std::ofstream profile(settings.profileFile.c_str());
+        Profiler::writeCsv(profile);
+#else
+        std::cerr << "Warning: built without PROFILING (make PROFILE=1), no phase timings." << std::endl;
+#endif
+    }
+    if (!settings.traceFile.empty()) {
+        std::ofstream trace(settings.traceFile.c_str());
+        Tracer::writeChromeTrace(trace);
+#ifndef PROFILING
+        std::cerr << "Warning: built without PROFILING (make PROFILE=1), the timeline is empty." << std::endl;
+#endif
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void printUsage (const char* exec)
+{
+    std::cerr << "Usage: " << exec << " [options]" << std::endl;
+    std::cerr << "  --size <cols>x<lines>   grid size (default 100x100)" << std::endl;
+    std::cerr << "  --viscosity <float>     viscosity (default 0.0001)" << std::endl;
+    std::cerr << "  --dt <float>            time step in seconds (default 1/60)" << std::endl;
+    std::cerr << "  --steps <int>           number of steps to simulate (default 1000)" << std::endl;
+    std::cerr << "  --pressure <solver>     gs, mg, fmg, cg or fft (default gs)" << std::endl;
+    std::cerr << "  --diffusion <solver>    gs, mg, fmg, cg or fft (default gs)" << std::endl;
+    std::cerr << "  --cycles <int>          V-cycles per multigrid solve (default 2)" << std::endl;
+    std::cerr << "  --preconditioner <name> mic or jacobi, for cg (default mic)" << std::endl;
+    std::cerr << "  --tolerance <float>     relative residual stopping cg (default 0.001)" << std::endl;
+    std::cerr << "  --max-iterations <int>  iterations cap for cg (default 200)" << std::endl;
+    std::cerr << "  --gs-tolerance <float>  relative residual stopping gs, 0 for fixed sweeps (default 0)" << std::endl;
+    std::cerr << "  --check-interval <int>  sweeps between two residual checks of gs (default 4)" << std::endl;
+    std::cerr << "  --max-sweeps <int>      sweeps cap for gs (default 20)" << std::endl;
+    std::cerr << "  --ordering <name>       lex or redblack (multithreaded), for gs (default lex)" << std::endl;
+    std::cerr << "  --blocking <int>        lex sweeps done in a single pass over the grid (default 8)" << std::endl;
+    std::cerr << "  --warm-start <yes|no>   start the pressure solves from the previous step (default no)" << std::endl;
+    std::cerr << "  --fused-density <yes|no> advect the density along with the velocity (default no)" << std::endl;
+    std::cerr << "  --scalars <int>         passive scalars transported with the density (default 0)" << std::endl;
+    std::cerr << "  --huge-pages <mode>     pages of the fields: none, transparent or explicit (default transparent)" << std::endl;
+    std::cerr << "  --pitch <dense|padded>  distance between the lines of the fields: nbCols, or padded (default dense)" << std::endl;
+    std::cerr << "  --threads <int>         threads of the parallel kernels, 0 for OMP_NUM_THREADS (default 0)" << std::endl;
+    std::cerr << "  --profile <file>        write the phase timings to a CSV file (PROFILE=1 builds)" << std::endl;
+    std::cerr << "  --trace <file>          write a Chrome trace of the phases, for Perfetto (PROFILE=1 builds)" << std::endl;
+    std::cerr << "  --counters <yes|no>     read the hardware counters of each phase, Linux only (PROFILE=1 builds)" << std::endl;
+}
+
+bool parseArguments (int argc, char *argv[], BatchSettings& settings)
+{
+    for (int i = 1 ; i < argc ; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+        if (i+1 >= argc) {
+            std::cerr << "Error: missing value for " << arg << "." << std::endl;
+            return false;
+        }
+
+        std::istringstream value(argv[++i]);
+        bool valid = true;
+        if (arg == "--size") {
+            char separator = 0;
+            valid = (value >> settings.nbCols >> separator >> settings.nbLines) && separator == 'x';
+            valid = valid && settings.nbCols >= 3 && settings.nbLines >= 3;
+        } else if (arg == "--viscosity") {
+            valid = static_cast<bool>(value >> settings.viscosity);
+        } else if (arg == "--dt") {
+            valid = static_cast<bool>(value >> settings.dt);
+        } else if (arg == "--steps") {
+            valid = (value >> settings.steps) && settings.steps > 0;
+        } else if (arg == "--pressure") {
+            valid = parseLinearSolver(value.str(), settings.pressureSolver);
+        } else if (arg == "--diffusion") {
+            valid = parseLinearSolver(value.str(), settings.diffusionSolver);
+        } else if (arg == "--cycles") {
+            valid = static_cast<bool>(value >> settings.multigridCycles);
+        } else if (arg == "--preconditioner") {
+            valid = true;
+            if (value.str() == "mic") {
+                settings.preconditioner = Preconditioner::MIC;
+            } else if (value.str() == "jacobi") {
+                settings.preconditioner = Preconditioner::JACOBI;
+            } else {
+                valid = false;
+            }
+        } else if (arg == "--tolerance") {
+            valid = static_cast<bool>(value >> settings.tolerance);
+        } else if (arg == "--max-iterations") {
+            valid = static_cast<bool>(value >> settings.maxIterations);
+        } else if (arg == "--gs-tolerance") {
+            valid = static_cast<bool>(value >> settings.relaxationTolerance);
+        } else if (arg == "--check-interval") {
+            valid = (value >> settings.checkInterval) && settings.checkInterval > 0;
+        } else if (arg == "--max-sweeps") {
+            valid = static_cast<bool>(value >> settings.maxSweeps);
+        } else if (arg == "--ordering") {
+            valid = true;
+            if (value.str() == "lex") {
+                settings.ordering = SweepOrdering::LEXICOGRAPHIC;
+            } else if (value.str() == "redblack") {
+                settings.ordering = SweepOrdering::RED_BLACK;
+            } else {
+                valid = false;
+            }
+        } else if (arg == "--blocking") {
+            valid = (value >> settings.sweepsPerPass) && settings.sweepsPerPass > 0;
+        } else if (arg == "--warm-start") {
+            valid = (value.str() == "yes" || value.str() == "no");
+            settings.warmStart = (value.str() == "yes");
+        } else if (arg == "--fused-density") {
+            valid = (value.str() == "yes" || value.str() == "no");
+            settings.fusedDensityAdvection = (value.str() == "yes");
+        } else if (arg == "--scalars") {
+            valid = static_cast<bool>(value >> settings.nbScalars);
+        } else if (arg == "--huge-pages") {
+            valid = parseHugePages(value.str(), settings.hugePages);
+        } else if (arg == "--pitch") {
+            valid = (value.str() == "dense" || value.str() == "padded");
+            settings.rowPitch = (value.str() == "padded") ? RowPitch::PADDED : RowPitch::DENSE;
+        } else if (arg == "--threads") {
+            valid = static_cast<bool>(value >> settings.nbThreads);
+        } else if (arg == "--profile") {
+            settings.profileFile = value.str();
+            valid = !settings.profileFile.empty();
+        } else if (arg == "--trace") {
+            settings.traceFile = value.str();
+            valid = !settings.traceFile.empty();
+        } else if (arg == "--counters") {
+            valid = (value.str() == "yes" || value.str() == "no");
+            settings.counters = (value.str() == "yes");
+        } else {
+            std::cerr << "Error: unknown option " << arg << "." << std::endl;
+            return false;
+        }
+
+        if (!valid) {
+            std::cerr << "Error: invalid value for " << arg << "." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool parseLinearSolver (std::string const& name, LinearSolver& solver)
+{
+    if (name == "gs") {
+        solver = LinearSolver::GAUSS_SEIDEL;
+    } else if (name == "mg") {
+        solver = LinearSolver::MULTIGRID;
+    } else if (name == "fmg") {
+        solver = LinearSolver::FULL_MULTIGRID;
+    } else if (name == "cg") {
+        solver = LinearSolver::CONJUGATE_GRADIENT;
+    } else if (name == "fft") {
+        solver = LinearSolver::SPECTRAL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool isIterative (LinearSolver solver)
+{
+    return solver == LinearSolver::GAUSS_SEIDEL || solver == LinearSolver::CONJUGATE_GRADIENT;
+}
+
+void printStats (std::string const& name, unsigned long iterations, float residual, unsigned int steps)
+{
+    std::cout << name << " iterations/step: " << static_cast<double>(iterations) / steps << std::endl;
+    std::cout << name << " max residual: " << residual << std::endl;
+}
+
+void printCounters()
+{
+    for (ProfilePhase const* phase : Profiler::getPhases()) {
+        if (!phase->hasCounters())
+            continue;
+
+        PerfCounters::Values const& counters = phase->getCounters();
+        std::cout << phase->getName() << " IPC: " << phase->getInstructionsPerCycle()
+                  << ", LLC misses/cell: " << phase->getPerCell(counters.llcMisses)
+                  << ", bytes/cell: " << phase->getBytesPerCell()
+                  << ", branch misses/cell: " << phase->getPerCell(counters.branchMisses) << std::endl;
+    }
+}
+
+void stir (FluidSolver& solver, unsigned int step)
+{
+    const float angle = 0.05f * static_cast<float>(step);
+    const glm::vec2 center(0.5f, 0.5f);
+    const glm::vec2 dir(0.01f * std::cos(angle), 0.01f * std::sin(angle));
+
+    solver.addDensity(center, 0.001f, 1.f);
+    solver.addVelocity(center, dir);
+
+    /* Each scalar has its own source, around the center */
+    for (unsigned int i = 0 ; i < solver.getNbScalars() ; ++i) {
+        const float sourceAngle = 6.2831853f * static_cast<float>(i) / static_cast<float>(solver.getNbScalars());
+        const glm::vec2 source = center + 0.1f * glm::vec2(std::cos(sourceAngle), std::sin(sourceAngle));
+        solver.addScalarSource(i, source, 0.001f, 0.1f);
+    }
+}
@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cstddef>
+
+#include "FluidSolver.hpp"
+#include "Simd.hpp"
+
+
+/* Prototype of the self-advection of a velocity stored as interleaved (x, y) pairs, for the
+ * advectVelocityInterleaved kernel of the bench: the solver keeps the components in two fields.
+ * Same back-trace and interpolation formulas as advectFields (Advection.cpp), whose helpers are
+ * copied here rather than exported from the solver library. */
+
+/* Size of dst, in bytes, above which advectFields streams (for one field) */
+static const std::size_t STREAMING_THRESHOLD = 1 << 23;
+
+/* Where the center of a cell comes from: between the cells corner, corner+1, corner+pitch and
+ * corner+pitch+1, at (h, v) from the first one */
+struct BackTrace
+{
+    int corner;
+    float h;
+    float v;
+};
+
+/* maxCol and maxLine are the centers of the last column and line of the outer ring */
+inline BackTrace backTrace (unsigned int pitch, float maxCol, float maxLine,
+                            unsigned int line, unsigned int col, float velX, float velY, float dt)
+{
+    float prevLine = static_cast<float>(line) - dt*velY;
+    float prevCol = static_cast<float>(col) - dt*velX;
+
+    prevLine = std::min(maxLine, std::max(0.5f, prevLine));
+    prevCol = std::min(maxCol, std::max(0.5f, prevCol));
+
+    int col0 = prevCol;
+    int line0 = prevLine;
+
+    BackTrace trace;
+    trace.corner = line0*pitch + col0;
+    trace.h = prevCol - static_cast<float>(col0);
+    trace.v = prevLine - static_cast<float>(line0);
+    return trace;
+}
+
+/* Bilinear interpolation of one component: src points to the component in the first pair,
+ * the cells are 2 floats apart */
+inline float interpolateComponent (float const* src, unsigned int pitch, BackTrace const& trace)
+{
+    const float h = trace.h, v = trace.v;
+    float const* corner = src + 2*trace.corner;
+    return h   *   (v*corner[2*pitch+2] + (1.f-v)*corner[2]) +
+           (1.f-h)*(v*corner[2*pitch]   + (1.f-v)*corner[0]);
+}
+
+inline void advectPair (float const* src, float* dst, unsigned int pitch, float maxCol, float maxLine,
+                        unsigned int line, unsigned int col, float dt)
+{
+    const unsigned int i = 2 * (line*pitch + col);
+    const BackTrace trace = backTrace(pitch, maxCol, maxLine, line, col, src[i], src[i+1], dt);
+    dst[i] = interpolateComponent(src, pitch, trace);
+    dst[i+1] = interpolateComponent(src + 1, pitch, trace);
+}
+
+#ifdef SIMD_ENABLED
+
+/* The (x, y) pairs of a then b split into their x and their y, and back */
+#if defined(__AVX512F__)
+inline void deinterleave (simd::Floats a, simd::Floats b, simd::Floats& x, simd::Floats& y)
+{
+    const simd::Ints even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    x = _mm512_permutex2var_ps(a, even, b);
+    y = _mm512_permutex2var_ps(a, _mm512_add_epi32(even, _mm512_set1_epi32(1)), b);
+}
+inline void interleave (simd::Floats x, simd::Floats y, simd::Floats& a, simd::Floats& b)
+{
+    a = _mm512_permutex2var_ps(x, _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23), y);
+    b = _mm512_permutex2var_ps(x, _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31), y);
+}
+#else
+inline void deinterleave (simd::Floats a, simd::Floats b, simd::Floats& x, simd::Floats& y)
+{
+    /* Shuffles stay within 128-bit halves: x0 x1 x4 x5 | x2 x3 x6 x7, then the middle quarters swap */
+    x = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+                                               _MM_SHUFFLE(3, 1, 2, 0)));
+    y = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))),
+                                               _MM_SHUFFLE(3, 1, 2, 0)));
+}
+inline void interleave (simd::Floats x, simd::Floats y, simd::Floats& a, simd::Floats& b)
+{
+    const simd::Floats low = _mm256_unpacklo_ps(x, y), high = _mm256_unpackhi_ps(x, y);
+    a = _mm256_permute2f128_ps(low, high, 0x20);
+    b = _mm256_permute2f128_ps(low, high, 0x31);
+}
+#endif
+
+/* advectLine of Advection.cpp on pairs: the pairs of a vector of cells are split into their
+ * components after loading and merged back before storing */
+template <bool STREAM>
+static void advectPairsLine (float const* src, float* dst, unsigned int nbCols, unsigned int pitch, unsigned int line,
+                             float maxCol, float maxLine, float dt)
+{
+    const unsigned int end = nbCols - 1;
+    unsigned int col = 1;
+    const unsigned int offset = line*pitch;
+
+    if (STREAM) {
+        for ( ; col < end && !simd::isAligned(dst + 2*(offset+col)) ; ++col) {
+            advectPair(src, dst, pitch, maxCol, maxLine, line, col, dt);
+        }
+    }
+
+    const simd::Floats dtV = simd::set(dt);
+    const simd::Floats one = simd::set(1.f);
+    const simd::Floats minPos = simd::set(0.5f);
+    const simd::Floats maxColV = simd::set(maxCol);
+    const simd::Floats maxLineV = simd::set(maxLine);
+    const simd::Floats lineV = simd::set(static_cast<float>(line));
+    const simd::Floats lanes = simd::iota();
+    const simd::Ints stride = simd::setInt(pitch);
+
+    for ( ; col + simd::WIDTH <= end ; col += simd::WIDTH) {
+        const unsigned int i = 2 * (offset + col);
+        const simd::Floats colV = simd::add(simd::set(static_cast<float>(col)), lanes);
+
+        simd::Floats velX, velY;
+        deinterleave(simd::load(src + i), simd::load(src + i + simd::WIDTH), velX, velY);
+
+        simd::Floats prevLine = simd::sub(lineV, simd::mul(dtV, velY));
+        simd::Floats prevCol = simd::sub(colV, simd::mul(dtV, velX));
+        prevLine = simd::min(simd::max(prevLine, minPos), maxLineV);
+        prevCol = simd::min(simd::max(prevCol, minPos), maxColV);
+
+        const simd::Ints col0 = simd::truncate(prevCol);
+        const simd::Ints line0 = simd::truncate(prevLine);
+        const simd::Floats h = simd::sub(prevCol, simd::toFloats(col0));
+        const simd::Floats v = simd::sub(prevLine, simd::toFloats(line0));
+        const simd::Floats oneMinusH = simd::sub(one, h);
+        const simd::Floats oneMinusV = simd::sub(one, v);
+        const simd::Ints cell = simd::addInt(simd::mulInt(line0, stride), col0);
+        const simd::Ints corner = simd::addInt(cell, cell);
+
+        simd::Floats results[2];
+        for (unsigned int component = 0 ; component < 2 ; ++component) {
+            float const* base = src + component;
+            const simd::Floats s00 = simd::gather(base, corner);
+            const simd::Floats s01 = simd::gather(base + 2, corner);
+            const simd::Floats s10 = simd::gather(base + 2*pitch, corner);
+            const simd::Floats s11 = simd::gather(base + 2*pitch + 2, corner);
+
+            const simd::Floats right = simd::add(simd::mul(v, s11), simd::mul(oneMinusV, s01));
+            const simd::Floats left = simd::add(simd::mul(v, s10), simd::mul(oneMinusV, s00));
+            results[component] = simd::add(simd::mul(h, right), simd::mul(oneMinusH, left));
+        }
+
+        simd::Floats first, second;
+        interleave(results[0], results[1], first, second);
+        if (STREAM) {
+            simd::stream(dst + i, first);
+            simd::stream(dst + i + simd::WIDTH, second);
+        } else {
+            simd::store(dst + i, first);
+            simd::store(dst + i + simd::WIDTH, second);
+        }
+    }
+
+    for ( ; col < end ; ++col) {
+        advectPair(src, dst, pitch, maxCol, maxLine, line, col, dt);
+    }
+}
+
+#endif
+
+void advectInterleavedVelocity (BufferFloat const& src, BufferFloat& dst,
+                                unsigned int nbCols, unsigned int nbLines, unsigned int pitch, float dt)
+{
+    const float maxCol = static_cast<float>(nbCols) - 1.5f;
+    const float maxLine = static_cast<float>(nbLines) - 1.5f;
+
+#ifdef SIMD_ENABLED
+    /* Streams from the same grid size as advectFields, whose destinations are half as large */
+    const bool pairsAligned = reinterpret_cast<std::size_t>(dst.data()) % (2*sizeof(float)) == 0;
+    if (dst.size() / 2 * sizeof(float) > STREAMING_THRESHOLD && pairsAligned) {
+        for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+            advectPairsLine<true>(src.data(), dst.data(), nbCols, pitch, line, maxCol, maxLine, dt);
+        }
+        simd::fence();
+    } else {
+        for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+            advectPairsLine<false>(src.data(), dst.data(), nbCols, pitch, line, maxCol, maxLine, dt);
+        }
+    }
+#else
+    for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+            advectPair(src.data(), dst.data(), pitch, maxCol, maxLine, line, col, dt);
+        }
+    }
+#endif
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cstddef>
+
+#include "FluidSolver.hpp"
+#include "Simd.hpp"
+
+
+/* Prototype of the advection of a field stored in square tiles, for the advectTiled kernel of the bench:
+ * the solver stores its fields line by line. A tile holds TILE x TILE cells line by line, and the tiles
+ * follow each other line by line, so that the cells a back-trace reads around a cell are in one or two
+ * tiles rather than in lines pitch floats apart. Same back-trace and interpolation formulas as advectFields
+ * (Advection.cpp), over the grid tile by tile. */
+
+static const unsigned int TILE_SHIFT = 4;
+static const unsigned int TILE = 1 << TILE_SHIFT;
+static const unsigned int TILE_MASK = TILE - 1;
+
+/* Size of dst, in bytes, above which advectFields streams */
+static const std::size_t STREAMING_THRESHOLD = 1 << 23;
+
+unsigned int getTiledIndex (unsigned int tilesPerLine, unsigned int line, unsigned int col)
+{
+    const unsigned int tile = (line >> TILE_SHIFT) * tilesPerLine + (col >> TILE_SHIFT);
+    return (tile << (2*TILE_SHIFT)) + ((line & TILE_MASK) << TILE_SHIFT) + (col & TILE_MASK);
+}
+
+unsigned int tileField (FluidSolver const& solver, BufferFloat const& field, BufferFloat& tiled)
+{
+    const unsigned int tilesPerLine = (solver.getNbCols() + TILE_MASK) >> TILE_SHIFT;
+    const unsigned int tilesPerCol = (solver.getNbLines() + TILE_MASK) >> TILE_SHIFT;
+
+    tiled.assign(static_cast<std::size_t>(tilesPerLine) * tilesPerCol * TILE * TILE, 0.f);
+    for (unsigned int line = 0 ; line < solver.getNbLines() ; ++line) {
+        for (unsigned int col = 0 ; col < solver.getNbCols() ; ++col) {
+            tiled[getTiledIndex(tilesPerLine, line, col)] = field[solver.index(line, col)];
+        }
+    }
+    return tilesPerLine;
+}
+
+/* advectCell of Advection.cpp, the four cells around the back-trace being looked up in their tiles */
+inline void advectTiledCell (float const* src, float* dst, float const* velX, float const* velY,
+                             unsigned int tilesPerLine, float maxCol, float maxLine,
+                             unsigned int line, unsigned int col, float dt)
+{
+    const unsigned int i = getTiledIndex(tilesPerLine, line, col);
+    float prevLine = static_cast<float>(line) - dt*velY[i];
+    float prevCol = static_cast<float>(col) - dt*velX[i];
+
+    prevLine = std::min(maxLine, std::max(0.5f, prevLine));
+    prevCol = std::min(maxCol, std::max(0.5f, prevCol));
+
+    const unsigned int col0 = static_cast<int>(prevCol);
+    const unsigned int line0 = static_cast<int>(prevLine);
+    const float h = prevCol - static_cast<float>(col0);
+    const float v = prevLine - static_cast<float>(line0);
+
+    dst[i] = h   *   (v*src[getTiledIndex(tilesPerLine, line0+1, col0+1)] + (1.f-v)*src[getTiledIndex(tilesPerLine, line0, col0+1)]) +
+             (1.f-h)*(v*src[getTiledIndex(tilesPerLine, line0+1, col0)]   + (1.f-v)*src[getTiledIndex(tilesPerLine, line0, col0)]);
+}
+
+#ifdef SIMD_ENABLED
+
+/* getTiledIndex of each lane: Simd.hpp has no integer shifts. As there, AVX-512 goes through the
+ * zero-masked forms, the plain ones leaving GCC to warn about their undefined masked-off lanes. */
+#if defined(__AVX512F__)
+inline simd::Ints getTiledIndices (simd::Ints line, simd::Ints col, simd::Ints tilesPerLine)
+{
+    const simd::Ints mask = simd::setInt(TILE_MASK);
+    const simd::Ints tile = simd::addInt(simd::mulInt(_mm512_maskz_srli_epi32(0xFFFF, line, TILE_SHIFT), tilesPerLine),
+                                         _mm512_maskz_srli_epi32(0xFFFF, col, TILE_SHIFT));
+    return simd::addInt(_mm512_maskz_slli_epi32(0xFFFF, tile, 2*TILE_SHIFT),
+                        simd::addInt(_mm512_maskz_slli_epi32(0xFFFF, _mm512_and_si512(line, mask), TILE_SHIFT),
+                                     _mm512_and_si512(col, mask)));
+}
+#else
+inline simd::Ints getTiledIndices (simd::Ints line, simd::Ints col, simd::Ints tilesPerLine)
+{
+    const simd::Ints mask = simd::setInt(TILE_MASK);
+    const simd::Ints tile = simd::addInt(simd::mulInt(_mm256_srli_epi32(line, TILE_SHIFT), tilesPerLine),
+                                         _mm256_srli_epi32(col, TILE_SHIFT));
+    return simd::addInt(_mm256_slli_epi32(tile, 2*TILE_SHIFT),
+                        simd::addInt(_mm256_slli_epi32(_mm256_and_si256(line, mask), TILE_SHIFT),
+                                     _mm256_and_si256(col, mask)));
+}
+#endif
+
+/* advectLine of Advection.cpp on the TILE cells of a line of a tile, which are contiguous.
+ * The corners are not: col0+1 and line0+1 may fall in the next tiles, so each is indexed on its own. */
+template <bool STREAM>
+static void advectTileLine (float const* src, float* dst, float const* velX, float const* velY,
+                            unsigned int tilesPerLine, unsigned int line, unsigned int firstCol,
+                            float maxCol, float maxLine, float dt)
+{
+    const simd::Floats dtV = simd::set(dt);
+    const simd::Floats one = simd::set(1.f);
+    const simd::Floats minPos = simd::set(0.5f);
+    const simd::Floats maxColV = simd::set(maxCol);
+    const simd::Floats maxLineV = simd::set(maxLine);
+    const simd::Floats lineV = simd::set(static_cast<float>(line));
+    const simd::Floats lanes = simd::iota();
+    const simd::Ints tilesV = simd::setInt(tilesPerLine);
+    const simd::Ints oneInt = simd::setInt(1);
+    const unsigned int offset = getTiledIndex(tilesPerLine, line, firstCol);
+
+    for (unsigned int col = 0 ; col < TILE ; col += simd::WIDTH) {
+        const unsigned int i = offset + col;
+        const simd::Floats colV = simd::add(simd::set(static_cast<float>(firstCol + col)), lanes);
+
+        simd::Floats prevLine = simd::sub(lineV, simd::mul(dtV, simd::load(velY + i)));
+        simd::Floats prevCol = simd::sub(colV, simd::mul(dtV, simd::load(velX + i)));
+        prevLine = simd::min(simd::max(prevLine, minPos), maxLineV);
+        prevCol = simd::min(simd::max(prevCol, minPos), maxColV);
+
+        const simd::Ints col0 = simd::truncate(prevCol);
+        const simd::Ints line0 = simd::truncate(prevLine);
+        const simd::Floats h = simd::sub(prevCol, simd::toFloats(col0));
+        const simd::Floats v = simd::sub(prevLine, simd::toFloats(line0));
+        const simd::Floats oneMinusH = simd::sub(one, h);
+        const simd::Floats oneMinusV = simd::sub(one, v);
+        const simd::Ints col1 = simd::addInt(col0, oneInt);
+        const simd::Ints line1 = simd::addInt(line0, oneInt);
+
+        const simd::Floats s00 = simd::gather(src, getTiledIndices(line0, col0, tilesV));
+        const simd::Floats s01 = simd::gather(src, getTiledIndices(line0, col1, tilesV));
+        const simd::Floats s10 = simd::gather(src, getTiledIndices(line1, col0, tilesV));
+        const simd::Floats s11 = simd::gather(src, getTiledIndices(line1, col1, tilesV));
+
+        const simd::Floats right = simd::add(simd::mul(v, s11), simd::mul(oneMinusV, s01));
+        const simd::Floats left = simd::add(simd::mul(v, s10), simd::mul(oneMinusV, s00));
+        const simd::Floats result = simd::add(simd::mul(h, right), simd::mul(oneMinusH, left));
+
+        if (STREAM) {
+            simd::stream(dst + i, result);
+        } else {
+            simd::store(dst + i, result);
+        }
+    }
+}
+
+#endif
+
+/* Advects the interior cells of a tile, whose first cell is (firstLine, firstCol) */
+template <bool STREAM>
+static void advectTile (float const* src, float* dst, float const* velX, float const* velY,
+                        unsigned int nbCols, unsigned int nbLines, unsigned int tilesPerLine,
+                        unsigned int firstLine, unsigned int firstCol, float maxCol, float maxLine, float dt)
+{
+    const unsigned int beginLine = std::max(firstLine, 1u), endLine = std::min(firstLine + TILE, nbLines - 1);
+    const unsigned int beginCol = std::max(firstCol, 1u), endCol = std::min(firstCol + TILE, nbCols - 1);
+
+#ifdef SIMD_ENABLED
+    /* Tiles without cells of the outer ring or beyond the grid, most of them, go by whole lines */
+    if (beginCol == firstCol && endCol == firstCol + TILE) {
+        for (unsigned int line = beginLine ; line < endLine ; ++line) {
+            advectTileLine<STREAM>(src, dst, velX, velY, tilesPerLine, line, firstCol, maxCol, maxLine, dt);
+        }
+        return;
+    }
+#endif
+    for (unsigned int line = beginLine ; line < endLine ; ++line) {
+        for (unsigned int col = beginCol ; col < endCol ; ++col) {
+            advectTiledCell(src, dst, velX, velY, tilesPerLine, maxCol, maxLine, line, col, dt);
+        }
+    }
+}
+
+void advectTiledField (BufferFloat const& src, BufferFloat& dst, BufferFloat const& velX, BufferFloat const& velY,
+                       unsigned int nbCols, unsigned int nbLines, unsigned int tilesPerLine, float dt)
+{
+    const float maxCol = static_cast<float>(nbCols) - 1.5f;
+    const float maxLine = static_cast<float>(nbLines) - 1.5f;
+
+    /* Tiles are 64 bytes aligned lines in aligned buffers, so the whole field can stream */
+    const bool stream = dst.size() * sizeof(float) > STREAMING_THRESHOLD;
+    for (unsigned int firstLine = 0 ; firstLine < nbLines ; firstLine += TILE) {
+        for (unsigned int firstCol = 0 ; firstCol < nbCols ; firstCol += TILE) {
+            if (stream) {
+                advectTile<true>(src.data(), dst.data(), velX.data(), velY.data(), nbCols, nbLines, tilesPerLine,
+                                 firstLine, firstCol, maxCol, maxLine, dt);
+            } else {
+                advectTile<false>(src.data(), dst.data(), velX.data(), velY.data(), nbCols, nbLines, tilesPerLine,
+                                  firstLine, firstCol, maxCol, maxLine, dt);
+            }
+        }
+    }
+#ifdef SIMD_ENABLED
+    if (stream) {
+        simd::fence();
+    }
+#endif
+}
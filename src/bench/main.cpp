@@ -0,0 +1,663 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <omp.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "FluidSolver.hpp"
+#include "Simd.hpp"
+
+
+/* Microbenchmarks of the phases of a step, on synthetic fields, written as JSON so that runs on
+ * different commits or machines can be compared. Each kernel is called a few times to warm up,
+ * then repeated until both a minimum count and a minimum time are reached.
+ * With several thread counts, each measure is compared to the one with the first count: strong
+ * scaling keeps the grid size, weak scaling grows the grid with the threads (same cells per thread).
+ * With several row pitches, each kernel is measured with each of them, e.g. to see what padding the
+ * lines does to power-of-two grids. */
+
+enum class Scaling
+{
+    NONE, //a single thread count
+    STRONG,
+    WEAK
+};
+
+struct BenchSettings
+{
+    std::vector<unsigned int> sizes;
+    std::vector<std::string> kernels;
+    unsigned int warmup;
+    unsigned int minRepetitions;
+    double minTime; //seconds
+    float displacement; //cells travelled by the synthetic flow in a step
+    SweepOrdering ordering; //of the Gauss-Seidel solves, only red-black ones are multithreaded
+    HugePages hugePages;
+    std::vector<RowPitch> rowPitches;
+    Scaling scaling;
+    std::vector<unsigned int> threads;
+    std::string output;
+    std::string label;
+};
+
+/* A phase of the step, and the memory it has to move per cell at the very least:
+ * every field it reads and writes, once */
+struct Kernel
+{
+    Kernel (std::string const& name, unsigned int bytesPerCell, std::function<void (FluidSolver&)> const& run,
+            std::function<void (FluidSolver const&)> const& prepare = nullptr) :
+                name(name), bytesPerCell(bytesPerCell), run(run), prepare(prepare)
+    {}
+
+    std::string name;
+    unsigned int bytesPerCell;
+    std::function<void (FluidSolver&)> run;
+    std::function<void (FluidSolver const&)> prepare; //untimed, once the synthetic state is set (optional)
+};
+
+/* The velocity of the solver stored as (x, y) pairs, which the solver itself does not do: the
+ * advectVelocityInterleaved kernel measures that layout against advectVelocity */
+struct InterleavedVelocity
+{
+    BufferFloat src;
+    BufferFloat dst;
+};
+
+/* The density and the velocity of the solver stored in square tiles, which the solver itself does not do:
+ * the advectTiled kernel measures that layout against advect */
+struct TiledFields
+{
+    unsigned int tilesPerLine;
+    BufferFloat densities;
+    BufferFloat velX;
+    BufferFloat velY;
+    BufferFloat dst;
+};
+
+struct Result
+{
+    std::string kernel;
+    unsigned int size;
+    unsigned int pitch;
+    HugePages hugePages; //obtained, which may differ from BenchSettings::hugePages
+    unsigned int threads;
+    unsigned int repetitions;
+    double median; //seconds
+    double mad; //median absolute deviation, seconds
+    double min;
+    double cellsPerSecond;
+    double gigabytesPerSecond;
+    /* Relative to the first thread count. In weak scaling, the speedup is scaled by the growth of the grid. */
+    double speedup;
+    double efficiency;
+};
+
+/* Where the threads of a parallel region run */
+struct Placement
+{
+    unsigned int threads;
+    std::string binding; //OMP_PROC_BIND policy
+    std::vector<int> cpus; //of each thread, -1 if unknown
+};
+
+void printUsage (const char* exec);
+bool parseArguments (int argc, char *argv[], BenchSettings& settings);
+bool parseList (std::string const& list, std::vector<std::string>& values);
+bool parseNumbers (std::string const& list, std::vector<unsigned int>& values);
+bool parseRowPitches (std::string const& list, std::vector<RowPitch>& rowPitches);
+
+/* 1, 2, 4... up to the number of processors, which is always included */
+std::vector<unsigned int> getDefaultThreadCounts();
+/* Grid size of a weak scaling measure: as many cells per thread as baseSize at baseThreads */
+unsigned int getWeakSize (unsigned int baseSize, unsigned int baseThreads, unsigned int threads);
+
+std::vector<Kernel> getKernels (float dt);
+
+/* Smooth blobs of density, and a grid of vortices moving each cell by up to `displacement` cells per step */
+void makeSyntheticFields (FluidSolver const& solver, float displacement, float dt,
+                          BufferFloat& densities, BufferFloat& velX, BufferFloat& velY);
+void interleaveVelocity (FluidSolver const& solver, InterleavedVelocity& velocity);
+/* Self-advection of a velocity stored as (x, y) pairs, lines 2*pitch floats apart (InterleavedVelocity.cpp) */
+void advectInterleavedVelocity (BufferFloat const& src, BufferFloat& dst,
+                                unsigned int nbCols, unsigned int nbLines, unsigned int pitch, float dt);
+void tileFields (FluidSolver const& solver, TiledFields& fields);
+/* A field of the solver copied into tiles, returning the number of tiles per line (TiledAdvection.cpp) */
+unsigned int tileField (FluidSolver const& solver, BufferFloat const& field, BufferFloat& tiled);
+/* advectField on tiled fields, tile by tile (TiledAdvection.cpp) */
+void advectTiledField (BufferFloat const& src, BufferFloat& dst, BufferFloat const& velX, BufferFloat const& velY,
+                       unsigned int nbCols, unsigned int nbLines, unsigned int tilesPerLine, float dt);
+
+Result measure (Kernel const& kernel, unsigned int size, RowPitch rowPitch, unsigned int threads,
+                BenchSettings const& settings, float dt);
+double median (std::vector<double> values);
+
+Placement getPlacement (unsigned int threads);
+std::string getBinding();
+
+void writeJson (std::ostream& stream, BenchSettings const& settings, std::vector<Result> const& results,
+                std::vector<Placement> const& placements);
+/* Contents of a JSON string: quotes, backslashes and control characters escaped */
+std::string escapeJson (std::string const& text);
+std::string getCpuModel();
+std::string getHostName();
+
+int main(int argc, char *argv[])
+{
+    BenchSettings settings;
+    settings.sizes = {64, 128, 256, 512, 1024, 2048, 4096};
+    settings.warmup = 2;
+    settings.minRepetitions = 5;
+    settings.minTime = 0.5;
+    settings.displacement = 2.f;
+    settings.ordering = SweepOrdering::LEXICOGRAPHIC;
+    settings.hugePages = HugePages::TRANSPARENT;
+    settings.rowPitches = {RowPitch::DENSE};
+    settings.scaling = Scaling::NONE;
+
+    if (!parseArguments(argc, argv, settings)) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (settings.threads.empty()) {
+        settings.threads = (settings.scaling == Scaling::NONE) ? std::vector<unsigned int>(1, omp_get_max_threads())
+                                                               : getDefaultThreadCounts();
+    }
+
+    const float dt = 1.f / 60.f;
+    std::vector<Kernel> kernels;
+    for (Kernel const& kernel : getKernels(dt)) {
+        if (settings.kernels.empty() ||
+            std::find(settings.kernels.begin(), settings.kernels.end(), kernel.name) != settings.kernels.end()) {
+            kernels.push_back(kernel);
+        }
+    }
+    if (kernels.empty()) {
+        std::cerr << "Error: no known kernel selected." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Placement> placements;
+    for (unsigned int threads : settings.threads) {
+        placements.push_back(getPlacement(threads));
+    }
+
+    const unsigned int baseThreads = settings.threads.front();
+    std::vector<Result> results;
+    for (unsigned int baseSize : settings.sizes) {
+        for (Kernel const& kernel : kernels) {
+            for (RowPitch rowPitch : settings.rowPitches) {
+                double baseMedian = 0.0;
+                for (unsigned int threads : settings.threads) {
+                    const unsigned int size = (settings.scaling == Scaling::WEAK) ?
+                                              getWeakSize(baseSize, baseThreads, threads) : baseSize;
+                    Result result = measure(kernel, size, rowPitch, threads, settings, dt);
+                    if (threads == baseThreads) {
+                        baseMedian = result.median;
+                    }
+                    const double ratio = baseMedian / result.median;
+                    const double growth = static_cast<double>(threads) / static_cast<double>(baseThreads);
+                    result.speedup = (settings.scaling == Scaling::WEAK) ? ratio * growth : ratio;
+                    result.efficiency = (settings.scaling == Scaling::WEAK) ? ratio : ratio / growth;
+                    results.push_back(result);
+
+                    std::cout << kernel.name << " " << size << "x" << size << " pitch " << result.pitch << " "
+                              << threads << " threads: median " << result.median * 1e3 << " ms (MAD "
+                              << result.mad * 1e3 << " ms, " << result.repetitions << " runs), "
+                              << result.cellsPerSecond * 1e-6 << " Mcells/s, " << result.gigabytesPerSecond << " GB/s";
+                    if (settings.scaling != Scaling::NONE) {
+                        std::cout << ", speedup " << result.speedup << ", efficiency " << result.efficiency;
+                    }
+                    std::cout << std::endl;
+                }
+            }
+        }
+    }
+
+    if (settings.output.empty()) {
+        writeJson(std::cout, settings, results, placements);
+    } else {
+        std::ofstream output(settings.output.c_str());
+        writeJson(output, settings, results, placements);
+        std::cout << "results written to " << settings.output << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void printUsage (const char* exec)
+{
+    std::cerr << "Usage: " << exec << " [options]" << std::endl;
+    std::cerr << "  --sizes <n,n...>        square grid sizes (default 64,128,256,512,1024,2048,4096)" << std::endl;
+    std::cerr << "  --kernels <name,...>    diffuse, advect, advectTiled, advectVelocity, advectVelocityInterleaved," << std::endl;
+    std::cerr << "                          project, boundaryConditions, addDensity, addVelocity, update (default all)" << std::endl;
+    std::cerr << "  --warmup <int>          untimed calls before measuring (default 2)" << std::endl;
+    std::cerr << "  --repetitions <int>     minimum number of timed calls (default 5)" << std::endl;
+    std::cerr << "  --min-time <float>      minimum time spent measuring each kernel, in seconds (default 0.5)" << std::endl;
+    std::cerr << "  --displacement <float>  cells travelled by the synthetic flow in a step (default 2)" << std::endl;
+    std::cerr << "  --ordering <name>       lex or redblack (multithreaded), for the Gauss-Seidel solves (default lex)" << std::endl;
+    std::cerr << "  --huge-pages <mode>     pages of the fields: none, transparent or explicit (default transparent)" << std::endl;
+    std::cerr << "  --pitches <name,...>    row pitches of the fields: dense (nbCols) and/or padded (default dense)" << std::endl;
+    std::cerr << "  --scaling <mode>        none, strong (same grid) or weak (same cells per thread) (default none)" << std::endl;
+    std::cerr << "  --threads <n,n...>      thread counts, the first one being the reference (default 1,2,4... up to" << std::endl;
+    std::cerr << "                          the number of processors when scaling, OpenMP default otherwise)" << std::endl;
+    std::cerr << "  --output <file>         JSON results (default standard output)" << std::endl;
+    std::cerr << "  --label <text>          recorded in the results, e.g. a commit (default empty)" << std::endl;
+}
+
+bool parseArguments (int argc, char *argv[], BenchSettings& settings)
+{
+    for (int i = 1 ; i < argc ; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+        if (i+1 >= argc) {
+            std::cerr << "Error: missing value for " << arg << "." << std::endl;
+            return false;
+        }
+
+        std::stringstream value(argv[++i]);
+        bool valid = true;
+        if (arg == "--sizes") {
+            valid = parseNumbers(value.str(), settings.sizes) &&
+                    *std::min_element(settings.sizes.begin(), settings.sizes.end()) >= 4;
+        } else if (arg == "--threads") {
+            valid = parseNumbers(value.str(), settings.threads) &&
+                    *std::min_element(settings.threads.begin(), settings.threads.end()) >= 1;
+        } else if (arg == "--ordering") {
+            if (value.str() == "lex") {
+                settings.ordering = SweepOrdering::LEXICOGRAPHIC;
+            } else if (value.str() == "redblack") {
+                settings.ordering = SweepOrdering::RED_BLACK;
+            } else {
+                valid = false;
+            }
+        } else if (arg == "--huge-pages") {
+            valid = parseHugePages(value.str(), settings.hugePages);
+        } else if (arg == "--pitches") {
+            valid = parseRowPitches(value.str(), settings.rowPitches);
+        } else if (arg == "--scaling") {
+            if (value.str() == "none") {
+                settings.scaling = Scaling::NONE;
+            } else if (value.str() == "strong") {
+                settings.scaling = Scaling::STRONG;
+            } else if (value.str() == "weak") {
+                settings.scaling = Scaling::WEAK;
+            } else {
+                valid = false;
+            }
+        } else if (arg == "--kernels") {
+            valid = parseList(value.str(), settings.kernels);
+        } else if (arg == "--warmup") {
+            valid = static_cast<bool>(value >> settings.warmup);
+        } else if (arg == "--repetitions") {
+            valid = (value >> settings.minRepetitions) && settings.minRepetitions > 0;
+        } else if (arg == "--min-time") {
+            valid = (value >> settings.minTime) && settings.minTime >= 0.0;
+        } else if (arg == "--displacement") {
+            valid = static_cast<bool>(value >> settings.displacement);
+        } else if (arg == "--output") {
+            settings.output = value.str();
+            valid = !settings.output.empty();
+        } else if (arg == "--label") {
+            settings.label = value.str();
+        } else {
+            std::cerr << "Error: unknown option " << arg << "." << std::endl;
+            return false;
+        }
+
+        if (!valid) {
+            std::cerr << "Error: invalid value for " << arg << "." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool parseList (std::string const& list, std::vector<std::string>& values)
+{
+    values.clear();
+    std::stringstream s(list);
+    std::string value;
+    while (std::getline(s, value, ',')) {
+        if (value.empty())
+            return false;
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+bool parseNumbers (std::string const& list, std::vector<unsigned int>& values)
+{
+    std::vector<std::string> strings;
+    if (!parseList(list, strings))
+        return false;
+
+    values.clear();
+    for (std::string const& string : strings) {
+        std::stringstream s(string);
+        unsigned int n;
+        if (!(s >> n))
+            return false;
+        values.push_back(n);
+    }
+    return true;
+}
+
+bool parseRowPitches (std::string const& list, std::vector<RowPitch>& rowPitches)
+{
+    std::vector<std::string> names;
+    if (!parseList(list, names))
+        return false;
+
+    rowPitches.clear();
+    for (std::string const& name : names) {
+        if (name == "dense") {
+            rowPitches.push_back(RowPitch::DENSE);
+        } else if (name == "padded") {
+            rowPitches.push_back(RowPitch::PADDED);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<unsigned int> getDefaultThreadCounts()
+{
+    const unsigned int nbProcs = omp_get_num_procs();
+    std::vector<unsigned int> counts;
+    for (unsigned int threads = 1 ; threads < nbProcs ; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(nbProcs);
+    return counts;
+}
+
+unsigned int getWeakSize (unsigned int baseSize, unsigned int baseThreads, unsigned int threads)
+{
+    return static_cast<unsigned int>(std::lround(baseSize * std::sqrt(static_cast<double>(threads) / baseThreads)));
+}
+
+std::vector<Kernel> getKernels (float dt)
+{
+    const unsigned int f = sizeof(float);
+    const unsigned int diffuse = 2*f; //source, result
+    const unsigned int advect = 4*f; //velocity, source, result
+    const unsigned int advectVelocity = 4*f; //velocity, result
+    const unsigned int project = 8*f; //velocity twice, pressure, divergence
+    /* The phases of update(): the diffusions of the density and of both components of the velocity,
+     * two projections, the advections of the density and of the velocity */
+    const unsigned int update = 3*diffuse + 2*project + advect + advectVelocity;
+    std::shared_ptr<InterleavedVelocity> interleaved = std::make_shared<InterleavedVelocity>();
+    std::shared_ptr<TiledFields> tiled = std::make_shared<TiledFields>();
+    return {
+        {"diffuse", diffuse, [dt](FluidSolver& solver) { solver.diffuseDensity(dt); }},
+        {"advect", advect, [dt](FluidSolver& solver) { solver.advectDensity(dt); }},
+        {"advectTiled", advect,
+            [dt, tiled](FluidSolver& solver) {
+                advectTiledField(tiled->densities, tiled->dst, tiled->velX, tiled->velY,
+                                 solver.getNbCols(), solver.getNbLines(), tiled->tilesPerLine, dt);
+            },
+            [tiled](FluidSolver const& solver) { tileFields(solver, *tiled); }},
+        {"advectVelocity", advectVelocity, [dt](FluidSolver& solver) { solver.advectVelocity(dt); }},
+        {"advectVelocityInterleaved", advectVelocity,
+            [dt, interleaved](FluidSolver& solver) {
+                advectInterleavedVelocity(interleaved->src, interleaved->dst,
+                                          solver.getNbCols(), solver.getNbLines(), solver.getPitch(), dt);
+            },
+            [interleaved](FluidSolver const& solver) { interleaveVelocity(solver, *interleaved); }},
+        {"project", project, [](FluidSolver& solver) { solver.projectVelocity(); }},
+        {"boundaryConditions", 0, [](FluidSolver& solver) { solver.applyBoundaries(); }}, //only the outer ring
+        {"addDensity", 2*f, [](FluidSolver& solver) { solver.addDensity(glm::vec2(0.5f, 0.5f), 0.001f, 1.f); }},
+        {"addVelocity", 4*f, [](FluidSolver& solver) { solver.addVelocity(glm::vec2(0.5f, 0.5f), glm::vec2(0.01f, 0.f)); }},
+        {"update", update, [dt](FluidSolver& solver) { solver.update(dt); }}
+    };
+}
+
+void makeSyntheticFields (FluidSolver const& solver, float displacement, float dt,
+                          BufferFloat& densities, BufferFloat& velX, BufferFloat& velY)
+{
+    const unsigned int nbCols = solver.getNbCols(), nbLines = solver.getNbLines();
+    const float pi = 3.14159265f;
+    const float speed = displacement / dt;
+
+    densities.assign(solver.getPitch()*nbLines, 0.f);
+    velX.assign(solver.getPitch()*nbLines, 0.f);
+    velY.assign(solver.getPitch()*nbLines, 0.f);
+    for (unsigned int line = 0 ; line < nbLines ; ++line) {
+        for (unsigned int col = 0 ; col < nbCols ; ++col) {
+            const float x = static_cast<float>(col) / static_cast<float>(nbCols);
+            const float y = static_cast<float>(line) / static_cast<float>(nbLines);
+            const unsigned int i = solver.index(line, col);
+
+            densities[i] = 0.5f + 0.5f * std::sin(6.f*pi*x) * std::sin(4.f*pi*y);
+            /* Taylor-Green vortices, divergence free */
+            velX[i] = speed * std::sin(4.f*pi*x) * std::cos(4.f*pi*y);
+            velY[i] = -speed * std::cos(4.f*pi*x) * std::sin(4.f*pi*y);
+        }
+    }
+}
+
+void interleaveVelocity (FluidSolver const& solver, InterleavedVelocity& velocity)
+{
+    BufferFloat const& velX = solver.getVelX();
+    BufferFloat const& velY = solver.getVelY();
+
+    velocity.src.resize(2*velX.size());
+    velocity.dst.assign(2*velX.size(), 0.f);
+    for (std::size_t i = 0 ; i < velX.size() ; ++i) {
+        velocity.src[2*i] = velX[i];
+        velocity.src[2*i + 1] = velY[i];
+    }
+}
+
+void tileFields (FluidSolver const& solver, TiledFields& fields)
+{
+    fields.tilesPerLine = tileField(solver, solver.getDensities(), fields.densities);
+    tileField(solver, solver.getVelX(), fields.velX);
+    tileField(solver, solver.getVelY(), fields.velY);
+    fields.dst.assign(fields.densities.size(), 0.f);
+}
+
+Result measure (Kernel const& kernel, unsigned int size, RowPitch rowPitch, unsigned int threads,
+                BenchSettings const& settings, float dt)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    FluidSolver solver(size, size, 0.0001f, settings.hugePages, rowPitch);
+    solver.setNbThreads(threads);
+    solver.setRelaxationOrdering(settings.ordering);
+    BufferFloat densities, velX, velY;
+    makeSyntheticFields(solver, settings.displacement, dt, densities, velX, velY);
+    if (kernel.prepare) {
+        solver.setState(densities, velX, velY);
+        kernel.prepare(solver);
+    }
+
+    /* Every call starts from the same synthetic state, so that iterative solvers do the same work */
+    for (unsigned int i = 0 ; i < settings.warmup ; ++i) {
+        solver.setState(densities, velX, velY);
+        kernel.run(solver);
+    }
+
+    std::vector<double> durations;
+    double total = 0.0;
+    while (durations.size() < settings.minRepetitions || total < settings.minTime) {
+        solver.setState(densities, velX, velY);
+
+        const Clock::time_point start = Clock::now();
+        kernel.run(solver);
+        durations.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+        total += durations.back();
+    }
+
+    Result result;
+    result.kernel = kernel.name;
+    result.size = size;
+    result.pitch = solver.getPitch();
+    result.hugePages = solver.getHugePages();
+    result.threads = threads;
+    result.repetitions = durations.size();
+    result.median = median(durations);
+    std::vector<double> deviations;
+    for (double duration : durations) {
+        deviations.push_back(std::abs(duration - result.median));
+    }
+    result.mad = median(deviations);
+    result.min = *std::min_element(durations.begin(), durations.end());
+
+    const double cells = static_cast<double>(size) * static_cast<double>(size);
+    result.cellsPerSecond = cells / result.median;
+    result.gigabytesPerSecond = cells * kernel.bytesPerCell / result.median * 1e-9;
+    result.speedup = 1.0;
+    result.efficiency = 1.0;
+    return result;
+}
+
+double median (std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    const std::size_t n = values.size();
+    return (n % 2 == 1) ? values[n/2] : 0.5 * (values[n/2 - 1] + values[n/2]);
+}
+
+Placement getPlacement (unsigned int threads)
+{
+    Placement placement;
+    placement.threads = threads;
+    placement.cpus.assign(threads, -1);
+
+    #pragma omp parallel num_threads(threads)
+    {
+        placement.cpus[omp_get_thread_num()] = sched_getcpu();
+        #pragma omp master
+        {
+            placement.binding = getBinding();
+        }
+    }
+    return placement;
+}
+
+std::string getBinding()
+{
+    switch (omp_get_proc_bind()) {
+        case omp_proc_bind_false:
+            return "false";
+        case omp_proc_bind_true:
+            return "true";
+        case omp_proc_bind_master:
+            return "master";
+        case omp_proc_bind_close:
+            return "close";
+        case omp_proc_bind_spread:
+            return "spread";
+        default:
+            return "unknown";
+    }
+}
+
+void writeJson (std::ostream& stream, BenchSettings const& settings, std::vector<Result> const& results,
+                std::vector<Placement> const& placements)
+{
+    char const* places = std::getenv("OMP_PLACES");
+    const char* scalings[] = {"none", "strong", "weak"};
+
+#ifdef SIMD_ENABLED
+    const unsigned int simdWidth = simd::WIDTH;
+#else
+    const unsigned int simdWidth = 1;
+#endif
+
+    stream << "{" << std::endl;
+    stream << "  \"label\": \"" << escapeJson(settings.label) << "\"," << std::endl;
+    stream << "  \"machine\": {" << std::endl;
+    stream << "    \"host\": \"" << escapeJson(getHostName()) << "\"," << std::endl;
+    stream << "    \"cpu\": \"" << escapeJson(getCpuModel()) << "\"," << std::endl;
+    stream << "    \"hardware_threads\": " << std::thread::hardware_concurrency() << "," << std::endl;
+    stream << "    \"omp_threads\": " << omp_get_max_threads() << "," << std::endl;
+    stream << "    \"simd_width\": " << simdWidth << "," << std::endl;
+    stream << "    \"omp_places\": \"" << escapeJson(places ? places : "") << "\"" << std::endl;
+    stream << "  }," << std::endl;
+    stream << "  \"huge_pages_requested\": \"" << getHugePagesName(settings.hugePages) << "\"," << std::endl;
+    stream << "  \"ordering\": \"" << ((settings.ordering == SweepOrdering::RED_BLACK) ? "redblack" : "lex") << "\"," << std::endl;
+    stream << "  \"scaling\": \"" << scalings[static_cast<int>(settings.scaling)] << "\"," << std::endl;
+    stream << "  \"placements\": [" << std::endl;
+    for (std::size_t i = 0 ; i < placements.size() ; ++i) {
+        Placement const& p = placements[i];
+        stream << "    {\"threads\": " << p.threads << ", \"binding\": \"" << escapeJson(p.binding) << "\", \"cpus\": [";
+        for (std::size_t t = 0 ; t < p.cpus.size() ; ++t) {
+            stream << ((t > 0) ? ", " : "") << p.cpus[t];
+        }
+        stream << "]}" << ((i+1 < placements.size()) ? "," : "") << std::endl;
+    }
+    stream << "  ]," << std::endl;
+    stream << "  \"warmup\": " << settings.warmup << "," << std::endl;
+    stream << "  \"displacement\": " << settings.displacement << "," << std::endl;
+    stream << "  \"results\": [" << std::endl;
+    for (std::size_t i = 0 ; i < results.size() ; ++i) {
+        Result const& r = results[i];
+        stream << "    {\"kernel\": \"" << r.kernel << "\", \"size\": " << r.size << ", \"pitch\": " << r.pitch
+               << ", \"huge_pages\": \"" << getHugePagesName(r.hugePages) << "\""
+               << ", \"threads\": " << r.threads
+               << ", \"repetitions\": " << r.repetitions
+               << ", \"median_s\": " << r.median << ", \"mad_s\": " << r.mad << ", \"min_s\": " << r.min
+               << ", \"cells_per_s\": " << r.cellsPerSecond << ", \"gb_per_s\": " << r.gigabytesPerSecond
+               << ", \"speedup\": " << r.speedup << ", \"efficiency\": " << r.efficiency << "}"
+               << ((i+1 < results.size()) ? "," : "") << std::endl;
+    }
+    stream << "  ]" << std::endl;
+    stream << "}" << std::endl;
+}
+
+std::string escapeJson (std::string const& text)
+{
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            const char* hex = "0123456789abcdef";
+            escaped += "\\u00";
+            escaped += hex[c >> 4];
+            escaped += hex[c & 0xf];
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string getCpuModel()
+{
+    std::ifstream cpuInfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuInfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            const std::size_t colon = line.find(':');
+            if (colon != std::string::npos && colon+2 <= line.size())
+                return line.substr(colon+2);
+        }
+    }
+    return "";
+}
+
+std::string getHostName()
+{
+    char name[256] = "";
+    gethostname(name, sizeof(name) - 1);
+    return name;
+}
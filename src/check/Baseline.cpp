@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "FluidSolver.hpp"
+
+
+/* Frozen baseline of the checks: FluidSolver::update written as plainly as possible, on dense fields,
+ * with every linear system solved to convergence in double precision by an unpreconditioned conjugate
+ * gradient. It shares no code with the solver library, so that the kernels and the linear solvers of
+ * the library are checked against the discrete equations rather than against each other.
+ * Keep it as it is: it is only correct by being simple. */
+
+/* Relative residual at which the baseline solves stop */
+static const double BASELINE_TOLERANCE = 1e-12;
+
+struct Grid
+{
+    unsigned int nbCols;
+    unsigned int nbLines;
+
+    unsigned int index (unsigned int line, unsigned int col) const
+    {
+        return line*nbCols + col;
+    }
+};
+
+/* Left/right columns are multiplied by hFactor, top/bottom lines by vFactor, corners are the average
+ * of their two neighbours */
+static void setBoundaries (Grid const& grid, BufferFloat& buffer, float hFactor, float vFactor)
+{
+    const unsigned int lastCol = grid.nbCols-1, lastLine = grid.nbLines-1;
+    for (unsigned int line = 1 ; line < lastLine ; ++line) {
+        buffer[grid.index(line, 0)] = hFactor * buffer[grid.index(line, 1)];
+        buffer[grid.index(line, lastCol)] = hFactor * buffer[grid.index(line, lastCol-1)];
+    }
+    for (unsigned int col = 1 ; col < lastCol ; ++col) {
+        buffer[grid.index(0, col)] = vFactor * buffer[grid.index(1, col)];
+        buffer[grid.index(lastLine, col)] = vFactor * buffer[grid.index(lastLine-1, col)];
+    }
+
+    buffer[grid.index(0, 0)] = 0.5f * (buffer[grid.index(1, 0)] + buffer[grid.index(0, 1)]);
+    buffer[grid.index(0, lastCol)] = 0.5f * (buffer[grid.index(1, lastCol)] + buffer[grid.index(0, lastCol-1)]);
+    buffer[grid.index(lastLine, 0)] = 0.5f * (buffer[grid.index(lastLine-1, 0)] + buffer[grid.index(lastLine, 1)]);
+    buffer[grid.index(lastLine, lastCol)] = 0.5f * (buffer[grid.index(lastLine-1, lastCol)] +
+                                                    buffer[grid.index(lastLine, lastCol-1)]);
+}
+
+/* diag*x - coupling*(sum of the 4 neighbours of x) on the interior, the neighbours in the outer ring
+ * being the cell itself times hFactor (left, right) or vFactor (top, bottom) */
+static void multiply (Grid const& grid, std::vector<double> const& x, std::vector<double>& result,
+                      double diag, double coupling, double hFactor, double vFactor)
+{
+    for (unsigned int line = 1 ; line < grid.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < grid.nbCols-1 ; ++col) {
+            const unsigned int i = grid.index(line, col);
+            const double left = (col == 1) ? hFactor * x[i] : x[i-1];
+            const double right = (col == grid.nbCols-2) ? hFactor * x[i] : x[i+1];
+            const double up = (line == 1) ? vFactor * x[i] : x[i-grid.nbCols];
+            const double down = (line == grid.nbLines-2) ? vFactor * x[i] : x[i+grid.nbCols];
+            result[i] = diag * x[i] - coupling * (left + right + up + down);
+        }
+    }
+}
+
+static double dot (Grid const& grid, std::vector<double> const& a, std::vector<double> const& b)
+{
+    double sum = 0.0;
+    for (unsigned int line = 1 ; line < grid.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < grid.nbCols-1 ; ++col) {
+            sum += a[grid.index(line, col)] * b[grid.index(line, col)];
+        }
+    }
+    return sum;
+}
+
+/* Subtracts the mean of the interior, the component of the null space of a singular system */
+static void removeMean (Grid const& grid, std::vector<double>& x)
+{
+    const double nbCells = static_cast<double>(grid.nbCols-2) * (grid.nbLines-2);
+    double sum = 0.0;
+    for (unsigned int line = 1 ; line < grid.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < grid.nbCols-1 ; ++col) {
+            sum += x[grid.index(line, col)];
+        }
+    }
+    for (unsigned int line = 1 ; line < grid.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < grid.nbCols-1 ; ++col) {
+            x[grid.index(line, col)] -= sum / nbCells;
+        }
+    }
+}
+
+/* Solves the system of multiply() for the interior of rhs, then sets the outer ring of x.
+ * When the system is singular (diag = 4*coupling, factors of 1), the solution with zero mean. */
+static void solve (Grid const& grid, BufferFloat& x, BufferFloat const& rhs, double diag, double coupling,
+                   float hFactor, float vFactor)
+{
+    const bool singular = (hFactor == 1.f && vFactor == 1.f && diag == 4.0*coupling);
+    const std::size_t size = grid.nbCols*grid.nbLines;
+    std::vector<double> solution(size, 0.0), r(size, 0.0), p(size, 0.0), q(size, 0.0);
+    for (unsigned int line = 1 ; line < grid.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < grid.nbCols-1 ; ++col) {
+            r[grid.index(line, col)] = rhs[grid.index(line, col)];
+        }
+    }
+    if (singular) {
+        removeMean(grid, r);
+    }
+
+    const double rhsNorm = std::sqrt(dot(grid, r, r));
+    p = r;
+    double rr = dot(grid, r, r);
+    for (unsigned int iteration = 0 ; iteration < 10*size && std::sqrt(rr) > BASELINE_TOLERANCE * rhsNorm ; ++iteration) {
+        multiply(grid, p, q, diag, coupling, hFactor, vFactor);
+        const double alpha = rr / dot(grid, p, q);
+        for (std::size_t i = 0 ; i < size ; ++i) {
+            solution[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+        }
+        const double previous = rr;
+        rr = dot(grid, r, r);
+        for (std::size_t i = 0 ; i < size ; ++i) {
+            p[i] = r[i] + (rr / previous) * p[i];
+        }
+    }
+    if (singular) {
+        removeMean(grid, solution);
+    }
+
+    for (unsigned int line = 1 ; line < grid.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < grid.nbCols-1 ; ++col) {
+            x[grid.index(line, col)] = static_cast<float>(solution[grid.index(line, col)]);
+        }
+    }
+    setBoundaries(grid, x, hFactor, vFactor);
+}
+
+/* Interior of dst from src, back-traced along (velX, velY) and clamped between the centers of the outer ring */
+static void advect (Grid const& grid, BufferFloat const& src, BufferFloat& dst,
+                    BufferFloat const& velX, BufferFloat const& velY, float dt)
+{
+    const float maxCol = static_cast<float>(grid.nbCols) - 1.5f;
+    const float maxLine = static_cast<float>(grid.nbLines) - 1.5f;
+    for (unsigned int line = 1 ; line < grid.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < grid.nbCols-1 ; ++col) {
+            float prevLine = static_cast<float>(line) - dt*velY[grid.index(line, col)];
+            float prevCol = static_cast<float>(col) - dt*velX[grid.index(line, col)];
+            prevLine = std::min(maxLine, std::max(0.5f, prevLine));
+            prevCol = std::min(maxCol, std::max(0.5f, prevCol));
+
+            const int col0 = prevCol, line0 = prevLine;
+            const float h = prevCol - static_cast<float>(col0);
+            const float v = prevLine - static_cast<float>(line0);
+            dst[grid.index(line, col)] = h   *   (v*src[grid.index(line0+1, col0+1)] + (1.f-v)*src[grid.index(line0, col0+1)]) +
+                                         (1.f-h)*(v*src[grid.index(line0+1, col0)]   + (1.f-v)*src[grid.index(line0, col0)]);
+        }
+    }
+}
+
+static void project (Grid const& grid, BufferFloat& velX, BufferFloat& velY)
+{
+    const float h = 1.f / std::sqrt(grid.nbLines*grid.nbCols);
+    BufferFloat div(grid.nbCols*grid.nbLines, 0.f), p(grid.nbCols*grid.nbLines, 0.f);
+    for (unsigned int line = 1 ; line < grid.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < grid.nbCols-1 ; ++col) {
+            div[grid.index(line, col)] = -0.5f * h * (velX[grid.index(line, col+1)] - velX[grid.index(line, col-1)] +
+                                                      velY[grid.index(line+1, col)] - velY[grid.index(line-1, col)]);
+        }
+    }
+
+    solve(grid, p, div, 4.0, 1.0, 1.f, 1.f);
+
+    for (unsigned int line = 1 ; line < grid.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < grid.nbCols-1 ; ++col) {
+            velX[grid.index(line, col)] -= 0.5f * (p[grid.index(line, col+1)] - p[grid.index(line, col-1)]) / h;
+            velY[grid.index(line, col)] -= 0.5f * (p[grid.index(line+1, col)] - p[grid.index(line-1, col)]) / h;
+        }
+    }
+    setBoundaries(grid, velX, -1.f, 1.f);
+    setBoundaries(grid, velY, 1.f, -1.f);
+}
+
+void baselineUpdate (BufferFloat& densities, BufferFloat& velX, BufferFloat& velY,
+                     unsigned int nbCols, unsigned int nbLines, float viscosity, float dt)
+{
+    const Grid grid = {nbCols, nbLines};
+    const float a = viscosity * nbCols * nbLines * dt;
+
+    /* Density: diffused, then advected back by the velocity of the start of the update */
+    BufferFloat diffused(densities.size(), 0.f);
+    solve(grid, diffused, densities, 1.0 + 4.0*a, a, 1.f, 1.f);
+    advect(grid, diffused, densities, velX, velY, dt);
+
+    /* Velocity: diffused and projected, then advected by itself and projected again */
+    BufferFloat diffusedX(velX.size(), 0.f), diffusedY(velY.size(), 0.f);
+    solve(grid, diffusedX, velX, 1.0 + 4.0*a, a, -1.f, 1.f);
+    solve(grid, diffusedY, velY, 1.0 + 4.0*a, a, 1.f, -1.f);
+    project(grid, diffusedX, diffusedY);
+
+    advect(grid, diffusedX, velX, diffusedX, diffusedY, dt);
+    advect(grid, diffusedY, velY, diffusedX, diffusedY, dt);
+    setBoundaries(grid, velX, -1.f, 1.f);
+    setBoundaries(grid, velY, 1.f, -1.f);
+    project(grid, velX, velY);
+}
@@ -0,0 +1,644 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <omp.h>
+
+#include "FluidSolver.hpp"
+
+
+/* Regression checks of the optimised kernels: deterministic scenarios are simulated with a reference
+ * configuration (plain line by line Gauss-Seidel sweeps, a single thread) and with an alternative one,
+ * and the resulting fields are compared. A value passes when it is within a number of ULPs of the
+ * reference, or within a fraction of the largest reference value of its field. The mass of the
+ * density and the divergence of the velocity are checked as well. Failing fields are written as
+ * error maps (PGM images, brighter where the error is larger).
+ * The reference fields can also be recorded to a file by one build and compared by another one,
+ * e.g. a scalar build against a vectorised one.
+ * The linear solvers are checked against a frozen baseline instead (Baseline.cpp), a plain implementation
+ * of the update solving every system to convergence: the reference configuration stops its sweeps long
+ * before, so the other solvers only roughly match it. */
+
+struct Tolerance
+{
+    std::int64_t ulps;
+    float relative; //of the largest absolute value of the reference field, negative to skip the fields
+    double mass; //relative difference of the total density
+    double divergence; //relative excess of the divergence of the velocity over the reference one
+};
+
+/* A deterministic simulation */
+struct Scenario
+{
+    std::string name;
+    unsigned int nbCols;
+    unsigned int nbLines;
+    unsigned int steps;
+    std::function<void (FluidSolver&)> initialize;
+    std::function<void (FluidSolver&, unsigned int step)> force;
+};
+
+typedef std::function<void (FluidSolver&)> Configuration;
+
+/* An alternative configuration, checked against the reference on every scenario */
+struct Check
+{
+    std::string name;
+    Configuration reference;
+    Configuration alternative;
+    RowPitch alternativePitch; //the reference is always dense
+    Tolerance tolerance;
+};
+
+/* A configuration checked against the frozen baseline on every scenario. Only the interiors are compared:
+ * the outer ring of the density keeps values of older steps, which the baseline does not replay. */
+struct BaselineCheck
+{
+    std::string name;
+    Configuration configuration;
+    Tolerance tolerance;
+};
+
+/* Without the padding of the lines, whatever the pitch of the solver */
+struct Fields
+{
+    BufferFloat densities;
+    BufferFloat velX;
+    BufferFloat velY;
+};
+
+struct CheckSettings
+{
+    std::int64_t ulps; //overrides of every tolerance, negative to keep them
+    float relative;
+    unsigned int nbThreads; //of the multithreaded alternatives
+    std::string recordFile;
+    std::string goldenFile;
+    std::string errorMapsDirectory;
+};
+
+void printUsage (const char* exec);
+bool parseArguments (int argc, char *argv[], CheckSettings& settings);
+
+std::vector<Scenario> getScenarios();
+Configuration getReference();
+std::vector<Check> getChecks (unsigned int nbThreads);
+std::vector<BaselineCheck> getBaselineChecks();
+
+Fields simulate (Scenario const& scenario, Configuration const& configuration, RowPitch rowPitch=RowPitch::DENSE);
+BufferFloat removePadding (FluidSolver const& solver, BufferFloat const& field);
+/* The scenario with baselineUpdate instead of FluidSolver::update, the forces still going through the solver */
+Fields simulateBaseline (Scenario const& scenario);
+/* One update, every system solved to convergence in double precision (Baseline.cpp). Fields are dense. */
+void baselineUpdate (BufferFloat& densities, BufferFloat& velX, BufferFloat& velY,
+                     unsigned int nbCols, unsigned int nbLines, float viscosity, float dt);
+/* The fields without their outer ring, and the scenario of that size */
+Fields getInterior (Fields const& fields, unsigned int nbCols, unsigned int nbLines);
+Scenario getInteriorScenario (Scenario const& scenario);
+
+/* Prints the differences, writes the error maps of the failing fields, returns true if all is within tolerance */
+bool compare (std::string const& name, Scenario const& scenario, Fields const& reference, Fields const& alternative,
+              Tolerance const& tolerance, std::string const& errorMapsDirectory);
+bool compareField (std::string const& name, unsigned int nbCols, unsigned int nbLines,
+                   BufferFloat const& reference, BufferFloat const& alternative, Tolerance const& tolerance,
+                   std::string const& errorMapPath);
+std::int64_t ulpDistance (float a, float b);
+double mass (Fields const& fields);
+double divergence (Fields const& fields, unsigned int nbCols, unsigned int nbLines);
+void writeErrorMap (std::string const& path, unsigned int nbCols, unsigned int nbLines, std::vector<float> const& errors);
+
+bool writeGolden (std::string const& path, std::vector<Scenario> const& scenarios, std::vector<Fields> const& fields);
+bool readGolden (std::string const& path, std::vector<Scenario> const& scenarios, std::vector<Fields>& fields);
+
+int main(int argc, char *argv[])
+{
+    CheckSettings settings;
+    settings.ulps = -1;
+    settings.relative = -1.f;
+    settings.nbThreads = std::max(2, omp_get_num_procs());
+    settings.errorMapsDirectory = ".";
+
+    if (!parseArguments(argc, argv, settings)) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<Scenario> scenarios = getScenarios();
+    std::vector<Fields> references, baselines;
+    for (Scenario const& scenario : scenarios) {
+        references.push_back(simulate(scenario, getReference()));
+        baselines.push_back(getInterior(simulateBaseline(scenario), scenario.nbCols, scenario.nbLines));
+    }
+
+    unsigned int nbChecks = 0, nbFailures = 0;
+    for (Check check : getChecks(settings.nbThreads)) {
+        if (settings.ulps >= 0) {
+            check.tolerance.ulps = settings.ulps;
+        }
+        if (settings.relative >= 0.f && check.tolerance.relative >= 0.f) {
+            check.tolerance.relative = settings.relative;
+        }
+
+        for (unsigned int i = 0 ; i < scenarios.size() ; ++i) {
+            Fields const& reference = check.reference ? simulate(scenarios[i], check.reference) : references[i];
+            const Fields alternative = simulate(scenarios[i], check.alternative, check.alternativePitch);
+            ++nbChecks;
+            if (!compare(check.name, scenarios[i], reference, alternative, check.tolerance, settings.errorMapsDirectory)) {
+                ++nbFailures;
+            }
+        }
+    }
+
+    for (BaselineCheck check : getBaselineChecks()) {
+        if (settings.ulps >= 0) {
+            check.tolerance.ulps = settings.ulps;
+        }
+        if (settings.relative >= 0.f && check.tolerance.relative >= 0.f) {
+            check.tolerance.relative = settings.relative;
+        }
+
+        for (unsigned int i = 0 ; i < scenarios.size() ; ++i) {
+            const Fields alternative = simulate(scenarios[i], check.configuration);
+            ++nbChecks;
+            if (!compare(check.name, getInteriorScenario(scenarios[i]), baselines[i],
+                         getInterior(alternative, scenarios[i].nbCols, scenarios[i].nbLines), check.tolerance,
+                         settings.errorMapsDirectory)) {
+                ++nbFailures;
+            }
+        }
+    }
+
+    if (!settings.goldenFile.empty()) {
+        std::vector<Fields> golden;
+        if (!readGolden(settings.goldenFile, scenarios, golden)) {
+            std::cerr << "Error: cannot read " << settings.goldenFile << ", or it holds other scenarios." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        /* Other builds may contract or vectorise the arithmetic differently */
+        Tolerance tolerance = {64, 1e-4f, 1e-4, 1e-2};
+        if (settings.ulps >= 0) {
+            tolerance.ulps = settings.ulps;
+        }
+        if (settings.relative >= 0.f) {
+            tolerance.relative = settings.relative;
+        }
+        for (unsigned int i = 0 ; i < scenarios.size() ; ++i) {
+            ++nbChecks;
+            if (!compare("golden", scenarios[i], golden[i], references[i], tolerance, settings.errorMapsDirectory)) {
+                ++nbFailures;
+            }
+        }
+    }
+
+    if (!settings.recordFile.empty()) {
+        if (!writeGolden(settings.recordFile, scenarios, references)) {
+            std::cerr << "Error: cannot write " << settings.recordFile << "." << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "reference fields written to " << settings.recordFile << std::endl;
+    }
+
+    std::cout << nbChecks - nbFailures << "/" << nbChecks << " checks passed" << std::endl;
+    return (nbFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void printUsage (const char* exec)
+{
+    std::cerr << "Usage: " << exec << " [options]" << std::endl;
+    std::cerr << "  --ulps <int>            ULPs a value may differ by, for every check" << std::endl;
+    std::cerr << "  --relative <float>      difference allowed, relative to the largest value of the field, for every check" << std::endl;
+    std::cerr << "  --threads <int>         threads of the multithreaded alternatives (default max(2, processors))" << std::endl;
+    std::cerr << "  --record <file>         write the reference fields, for another build to compare with" << std::endl;
+    std::cerr << "  --golden <file>         compare the reference fields with the ones recorded in that file" << std::endl;
+    std::cerr << "  --error-maps <dir>      where the error maps of failing fields go (default .)" << std::endl;
+}
+
+bool parseArguments (int argc, char *argv[], CheckSettings& settings)
+{
+    for (int i = 1 ; i < argc ; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        }
+        if (i+1 >= argc) {
+            std::cerr << "Error: missing value for " << arg << "." << std::endl;
+            return false;
+        }
+
+        std::stringstream value(argv[++i]);
+        bool valid = true;
+        if (arg == "--ulps") {
+            valid = (value >> settings.ulps) && settings.ulps >= 0;
+        } else if (arg == "--relative") {
+            valid = (value >> settings.relative) && settings.relative >= 0.f;
+        } else if (arg == "--threads") {
+            valid = (value >> settings.nbThreads) && settings.nbThreads > 0;
+        } else if (arg == "--record") {
+            settings.recordFile = value.str();
+            valid = !settings.recordFile.empty();
+        } else if (arg == "--golden") {
+            settings.goldenFile = value.str();
+            valid = !settings.goldenFile.empty();
+        } else if (arg == "--error-maps") {
+            settings.errorMapsDirectory = value.str();
+            valid = !settings.errorMapsDirectory.empty();
+        } else {
+            std::cerr << "Error: unknown option " << arg << "." << std::endl;
+            return false;
+        }
+
+        if (!valid) {
+            std::cerr << "Error: invalid value for " << arg << "." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<Scenario> getScenarios()
+{
+    /* Interior sizes without large prime factors, transformed by the mixed-radix FFT */
+    Scenario stir = {"stir", 66, 66, 60,
+        [](FluidSolver&) {},
+        [](FluidSolver& solver, unsigned int step) {
+            const float angle = 0.05f * static_cast<float>(step);
+            const glm::vec2 center(0.5f, 0.5f);
+            solver.addDensity(center, 0.001f, 1.f);
+            solver.addVelocity(center, glm::vec2(0.01f * std::cos(angle), 0.01f * std::sin(angle)));
+        }};
+
+    /* Taylor-Green vortices carrying density blobs, on a rectangular grid */
+    Scenario vortices = {"vortices", 98, 82, 30,
+        [](FluidSolver& solver) {
+            const unsigned int nbCols = solver.getNbCols(), nbLines = solver.getNbLines();
+            const float pi = 3.14159265f;
+            const unsigned int size = solver.getPitch()*nbLines;
+            BufferFloat densities(size, 0.f), velX(size, 0.f), velY(size, 0.f);
+            for (unsigned int line = 0 ; line < nbLines ; ++line) {
+                for (unsigned int col = 0 ; col < nbCols ; ++col) {
+                    const float x = static_cast<float>(col) / static_cast<float>(nbCols);
+                    const float y = static_cast<float>(line) / static_cast<float>(nbLines);
+                    const unsigned int i = solver.index(line, col);
+                    densities[i] = 0.5f + 0.5f * std::sin(6.f*pi*x) * std::sin(4.f*pi*y);
+                    velX[i] = 120.f * std::sin(4.f*pi*x) * std::cos(4.f*pi*y);
+                    velY[i] = -120.f * std::cos(4.f*pi*x) * std::sin(4.f*pi*y);
+                }
+            }
+            solver.setState(densities, velX, velY);
+        },
+        [](FluidSolver&, unsigned int) {}};
+
+    /* A jet off the center, on interior sizes 38 = 2*19 and 34 = 2*17 left to Bluestein's algorithm */
+    Scenario jet = {"jet", 40, 36, 40,
+        [](FluidSolver&) {},
+        [](FluidSolver& solver, unsigned int) {
+            const glm::vec2 source(0.3f, 0.25f);
+            solver.addDensity(source, 0.002f, 1.f);
+            solver.addVelocity(source, glm::vec2(0.004f, 0.008f));
+        }};
+
+    return {stir, vortices, jet};
+}
+
+Configuration getReference()
+{
+    return [](FluidSolver& solver) {
+        solver.setRelaxationBlocking(1);
+        solver.setNbThreads(1);
+    };
+}
+
+std::vector<Check> getChecks (unsigned int nbThreads)
+{
+    const Configuration reference = getReference();
+    const Tolerance exact = {0, 0.f, 0.0, 0.0};
+    const RowPitch dense = RowPitch::DENSE, padded = RowPitch::PADDED;
+
+    std::vector<Check> checks;
+
+    /* Same arithmetic, in another order of the cells or another layout: bitwise identical */
+    checks.push_back({"temporal blocking", Configuration(),
+        [reference](FluidSolver& solver) { reference(solver); solver.setRelaxationBlocking(8); }, dense, exact});
+    checks.push_back({"passive scalars", Configuration(),
+        [reference](FluidSolver& solver) { reference(solver); solver.addScalar(); solver.addScalar(); solver.addScalar(); },
+        dense, exact});
+    checks.push_back({"red-black threads",
+        [reference](FluidSolver& solver) { reference(solver); solver.setRelaxationOrdering(SweepOrdering::RED_BLACK); },
+        [reference, nbThreads](FluidSolver& solver) {
+            reference(solver);
+            solver.setRelaxationOrdering(SweepOrdering::RED_BLACK);
+            solver.setNbThreads(nbThreads);
+        }, dense, exact});
+    checks.push_back({"padded rows", Configuration(), reference, padded, exact});
+    const std::vector<std::pair<std::string, LinearSolver>> solvers = {{"multigrid", LinearSolver::MULTIGRID},
+                                                                       {"conjugate gradient", LinearSolver::CONJUGATE_GRADIENT},
+                                                                       {"spectral", LinearSolver::SPECTRAL}};
+    for (auto const& solver : solvers) {
+        const LinearSolver method = solver.second;
+        const Configuration configuration = [reference, method](FluidSolver& s) {
+            reference(s);
+            s.setPressureSolver(method);
+            s.setDiffusionSolver(method);
+        };
+        checks.push_back({"padded rows, " + solver.first, configuration, configuration, padded, exact});
+    }
+
+    /* Another order of the same sweeps: only close, and the projection must not get worse */
+    const Tolerance approximate = {0, 0.1f, 5e-2, 5e-2};
+    checks.push_back({"red-black ordering", Configuration(),
+        [reference](FluidSolver& solver) { reference(solver); solver.setRelaxationOrdering(SweepOrdering::RED_BLACK); },
+        dense, approximate});
+
+    return checks;
+}
+
+std::vector<BaselineCheck> getBaselineChecks()
+{
+    const Configuration reference = getReference();
+    std::vector<BaselineCheck> checks;
+
+    /* Each solver for both systems. Converged solves only differ from the baseline by the rounding of
+     * floats (a few millionths of the largest values); two V-cycles leave errors of about a thousandth
+     * and a divergence a few percent higher. */
+    const Tolerance converged = {0, 1e-4f, 1e-5, 1e-3};
+    const Tolerance vCycles = {0, 5e-3f, 1e-4, 0.1};
+    const auto solver = [reference](LinearSolver method) {
+        return [reference, method](FluidSolver& s) {
+            reference(s);
+            s.setPressureSolver(method);
+            s.setDiffusionSolver(method);
+        };
+    };
+    checks.push_back({"baseline, gauss-seidel", [reference](FluidSolver& s) {
+            reference(s);
+            s.setRelaxationTolerance(1e-6f);
+            s.setRelaxationMaxSweeps(100000);
+        }, converged});
+    const Configuration conjugateGradient = solver(LinearSolver::CONJUGATE_GRADIENT);
+    checks.push_back({"baseline, conjugate gradient", [conjugateGradient](FluidSolver& s) {
+            conjugateGradient(s);
+            s.setTolerance(1e-6f);
+            s.setMaxIterations(10000);
+        }, converged});
+    checks.push_back({"baseline, spectral", solver(LinearSolver::SPECTRAL), converged});
+    checks.push_back({"baseline, full multigrid", solver(LinearSolver::FULL_MULTIGRID), converged});
+    checks.push_back({"baseline, multigrid", solver(LinearSolver::MULTIGRID), vCycles});
+
+    return checks;
+}
+
+/* Of every simulation */
+static const float TIME_STEP = 1.f / 60.f;
+static const float VISCOSITY = 0.0001f;
+
+Fields simulate (Scenario const& scenario, Configuration const& configuration, RowPitch rowPitch)
+{
+    FluidSolver solver(scenario.nbCols, scenario.nbLines, VISCOSITY, HugePages::TRANSPARENT, rowPitch);
+    configuration(solver);
+    scenario.initialize(solver);
+    for (unsigned int step = 0 ; step < scenario.steps ; ++step) {
+        scenario.force(solver, step);
+        solver.update(TIME_STEP);
+    }
+
+    Fields fields;
+    fields.densities = removePadding(solver, solver.getDensities());
+    fields.velX = removePadding(solver, solver.getVelX());
+    fields.velY = removePadding(solver, solver.getVelY());
+    return fields;
+}
+
+BufferFloat removePadding (FluidSolver const& solver, BufferFloat const& field)
+{
+    const unsigned int nbCols = solver.getNbCols(), nbLines = solver.getNbLines();
+    BufferFloat dense(nbCols*nbLines);
+    for (unsigned int line = 0 ; line < nbLines ; ++line) {
+        std::copy(field.begin() + solver.index(line, 0), field.begin() + solver.index(line, nbCols),
+                  dense.begin() + line*nbCols);
+    }
+    return dense;
+}
+
+Fields simulateBaseline (Scenario const& scenario)
+{
+    FluidSolver solver(scenario.nbCols, scenario.nbLines, VISCOSITY);
+    scenario.initialize(solver);
+    for (unsigned int step = 0 ; step < scenario.steps ; ++step) {
+        scenario.force(solver, step);
+
+        BufferFloat densities = solver.getDensities(), velX = solver.getVelX(), velY = solver.getVelY();
+        baselineUpdate(densities, velX, velY, scenario.nbCols, scenario.nbLines, VISCOSITY, TIME_STEP);
+        solver.setState(densities, velX, velY);
+    }
+
+    Fields fields;
+    fields.densities = solver.getDensities();
+    fields.velX = solver.getVelX();
+    fields.velY = solver.getVelY();
+    return fields;
+}
+
+Fields getInterior (Fields const& fields, unsigned int nbCols, unsigned int nbLines)
+{
+    Fields interior;
+    for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+        const unsigned int start = line*nbCols + 1, end = line*nbCols + nbCols-1;
+        interior.densities.insert(interior.densities.end(), fields.densities.begin() + start, fields.densities.begin() + end);
+        interior.velX.insert(interior.velX.end(), fields.velX.begin() + start, fields.velX.begin() + end);
+        interior.velY.insert(interior.velY.end(), fields.velY.begin() + start, fields.velY.begin() + end);
+    }
+    return interior;
+}
+
+Scenario getInteriorScenario (Scenario const& scenario)
+{
+    Scenario interior = scenario;
+    interior.nbCols -= 2;
+    interior.nbLines -= 2;
+    return interior;
+}
+
+bool compare (std::string const& name, Scenario const& scenario, Fields const& reference, Fields const& alternative,
+              Tolerance const& tolerance, std::string const& errorMapsDirectory)
+{
+    std::cout << name << ", " << scenario.name << ":" << std::endl;
+
+    std::string prefix = name + "-" + scenario.name + "-";
+    std::replace(prefix.begin(), prefix.end(), ' ', '_');
+    prefix = errorMapsDirectory + "/" + prefix;
+
+    bool passed = true;
+    if (tolerance.relative >= 0.f) {
+        passed &= compareField("density", scenario.nbCols, scenario.nbLines, reference.densities, alternative.densities,
+                               tolerance, prefix + "density.pgm");
+        passed &= compareField("velX", scenario.nbCols, scenario.nbLines, reference.velX, alternative.velX,
+                               tolerance, prefix + "velX.pgm");
+        passed &= compareField("velY", scenario.nbCols, scenario.nbLines, reference.velY, alternative.velY,
+                               tolerance, prefix + "velY.pgm");
+    }
+
+    const double referenceMass = mass(reference), alternativeMass = mass(alternative);
+    const double massError = std::abs(alternativeMass - referenceMass) / std::max(std::abs(referenceMass), 1e-30);
+    const bool massPassed = (massError <= tolerance.mass);
+    std::cout << "  mass: " << alternativeMass << " (reference " << referenceMass << ")"
+              << (massPassed ? "" : "  FAILED") << std::endl;
+
+    const double referenceDivergence = divergence(reference, scenario.nbCols, scenario.nbLines);
+    const double alternativeDivergence = divergence(alternative, scenario.nbCols, scenario.nbLines);
+    const bool divergencePassed = (alternativeDivergence <= referenceDivergence * (1.0 + tolerance.divergence));
+    std::cout << "  divergence: " << alternativeDivergence << " (reference " << referenceDivergence << ")"
+              << (divergencePassed ? "" : "  FAILED") << std::endl;
+
+    return passed && massPassed && divergencePassed;
+}
+
+bool compareField (std::string const& name, unsigned int nbCols, unsigned int nbLines,
+                   BufferFloat const& reference, BufferFloat const& alternative, Tolerance const& tolerance,
+                   std::string const& errorMapPath)
+{
+    float scale = 0.f;
+    for (float value : reference) {
+        scale = std::max(scale, std::abs(value));
+    }
+    const float allowed = tolerance.relative * scale;
+
+    std::vector<float> errors(reference.size());
+    std::int64_t maxUlps = 0;
+    float maxError = 0.f;
+    unsigned int worst = 0, nbFailing = 0;
+    for (unsigned int i = 0 ; i < reference.size() ; ++i) {
+        const std::int64_t ulps = ulpDistance(reference[i], alternative[i]);
+        errors[i] = std::abs(alternative[i] - reference[i]);
+        if (ulps > tolerance.ulps && !(errors[i] <= allowed)) {
+            ++nbFailing;
+        }
+        maxUlps = std::max(maxUlps, ulps);
+        if (!(errors[i] <= maxError)) {
+            maxError = errors[i];
+            worst = i;
+        }
+    }
+
+    std::cout << "  " << name << ": max error " << maxError << " (" << maxError / std::max(scale, 1e-30f)
+              << " of the largest value), " << maxUlps << " ULPs";
+    if (maxError > 0.f) {
+        std::cout << ", worst at line " << worst / nbCols << " col " << worst % nbCols;
+    }
+    if (nbFailing == 0) {
+        std::cout << std::endl;
+        return true;
+    }
+
+    std::cout << "  FAILED on " << nbFailing << " cells, see " << errorMapPath << std::endl;
+    writeErrorMap(errorMapPath, nbCols, nbLines, errors);
+    return false;
+}
+
+std::int64_t ulpDistance (float a, float b)
+{
+    if (std::isnan(a) || std::isnan(b))
+        return (std::isnan(a) && std::isnan(b)) ? 0 : INT64_MAX;
+
+    /* Maps the floats to integers in the same order, -0 and +0 both to 0 */
+    std::int32_t ia, ib;
+    std::memcpy(&ia, &a, sizeof(float));
+    std::memcpy(&ib, &b, sizeof(float));
+    const std::int64_t la = (ia < 0) ? -static_cast<std::int64_t>(ia & 0x7FFFFFFF) : ia;
+    const std::int64_t lb = (ib < 0) ? -static_cast<std::int64_t>(ib & 0x7FFFFFFF) : ib;
+    return std::abs(la - lb);
+}
+
+double mass (Fields const& fields)
+{
+    double total = 0.0;
+    for (float density : fields.densities) {
+        total += density;
+    }
+    return total;
+}
+
+double divergence (Fields const& fields, unsigned int nbCols, unsigned int nbLines)
+{
+    /* L2 norm over the interior, with the central differences of the projection */
+    double sum = 0.0;
+    for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+            const unsigned int i = line*nbCols + col;
+            const double div = 0.5 * (fields.velX[i+1] - fields.velX[i-1] + fields.velY[i+nbCols] - fields.velY[i-nbCols]);
+            sum += div * div;
+        }
+    }
+    return std::sqrt(sum);
+}
+
+void writeErrorMap (std::string const& path, unsigned int nbCols, unsigned int nbLines, std::vector<float> const& errors)
+{
+    float maxError = 0.f;
+    for (float error : errors) {
+        if (std::isfinite(error)) {
+            maxError = std::max(maxError, error);
+        }
+    }
+
+    /* Binary greymap, first line of the grid at the bottom like in the window */
+    std::ofstream image(path.c_str(), std::ios::binary);
+    image << "P5\n" << nbCols << " " << nbLines << "\n255\n";
+    for (unsigned int line = nbLines ; line-- > 0 ; ) {
+        for (unsigned int col = 0 ; col < nbCols ; ++col) {
+            const float error = errors[line*nbCols + col];
+            const float level = std::isfinite(error) ? ((maxError > 0.f) ? error / maxError : 0.f) : 1.f;
+            image.put(static_cast<char>(static_cast<unsigned char>(255.f * level)));
+        }
+    }
+}
+
+/* Golden files: a header, then for each scenario its size and its density, velX and velY fields */
+static const char GOLDEN_HEADER[] = "navier-stokes golden 1\n";
+
+bool writeGolden (std::string const& path, std::vector<Scenario> const& scenarios, std::vector<Fields> const& fields)
+{
+    std::ofstream file(path.c_str(), std::ios::binary);
+    file.write(GOLDEN_HEADER, sizeof(GOLDEN_HEADER) - 1);
+    for (unsigned int i = 0 ; i < scenarios.size() ; ++i) {
+        const std::uint32_t size[2] = {scenarios[i].nbCols, scenarios[i].nbLines};
+        file.write(reinterpret_cast<char const*>(size), sizeof(size));
+        for (BufferFloat const* field : {&fields[i].densities, &fields[i].velX, &fields[i].velY}) {
+            file.write(reinterpret_cast<char const*>(field->data()), field->size() * sizeof(float));
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+bool readGolden (std::string const& path, std::vector<Scenario> const& scenarios, std::vector<Fields>& fields)
+{
+    std::ifstream file(path.c_str(), std::ios::binary);
+    std::string header(sizeof(GOLDEN_HEADER) - 1, '\0');
+    if (!file.read(&header[0], header.size()) || header != GOLDEN_HEADER)
+        return false;
+
+    fields.resize(scenarios.size());
+    for (unsigned int i = 0 ; i < scenarios.size() ; ++i) {
+        std::uint32_t size[2];
+        if (!file.read(reinterpret_cast<char*>(size), sizeof(size)) ||
+            size[0] != scenarios[i].nbCols || size[1] != scenarios[i].nbLines)
+            return false;
+
+        for (BufferFloat* field : {&fields[i].densities, &fields[i].velX, &fields[i].velY}) {
+            field->resize(size[0] * size[1]);
+            if (!file.read(reinterpret_cast<char*>(field->data()), field->size() * sizeof(float)))
+                return false;
+        }
+    }
+    return true;
+}
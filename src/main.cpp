@@ -1,5 +1,6 @@
 #include <cstdlib>
 #include <cmath>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
@@ -12,6 +13,9 @@
 #include <GL/glew.h>
 
 #include "FluidCPU.hpp"
+#include "PerfCounters.hpp"
+#include "Profiler.hpp"
+#include "Tracer.hpp"
 
 
 /* Returns relative mouse position in the window (in [0,1]x[0,1]) */
@@ -47,6 +51,8 @@ int main(int argc, char *argv[])
     sf::Vector2f mousePos = getRelativeMousePos(window);
     bool drawDensity = true, drawVelocity = false;
     while (window.isOpen()) {
+        TRACE_SCOPE("frame");
+
         sf::Event event;
         while (window.pollEvent(event)) {
             switch (event.type) {
@@ -66,6 +72,25 @@ int main(int argc, char *argv[])
                     else if (event.key.code == sf::Keyboard::O) {
                         drawVelocity = !drawVelocity;
                     }
+#ifdef PROFILING
+                    else if (event.key.code == sf::Keyboard::T) {
+                        if (Tracer::isRecording()) {
+                            Tracer::stop();
+                            std::ofstream trace("trace.json");
+                            Tracer::writeChromeTrace(trace);
+                            std::cout << "timeline written to trace.json" << std::endl;
+                        } else {
+                            Tracer::start();
+                        }
+                    }
+                    else if (event.key.code == sf::Keyboard::C) {
+                        if (PerfCounters::isOpen()) {
+                            PerfCounters::close();
+                        } else if (!PerfCounters::open()) {
+                            std::cout << "hardware counters unavailable" << std::endl;
+                        }
+                    }
+#endif
                 break;
                 case sf::Event::MouseButtonPressed:
                     if (event.mouseButton.button == sf::Mouse::Left) {
@@ -104,6 +129,11 @@ int main(int argc, char *argv[])
             s << "size: " << fluid.getSize().x << "x" << fluid.getSize().y << std::endl;
             s << "draw density (I): " << drawDensity << std::endl;
             s << "draw velocity (O): " << drawVelocity;
+#ifdef PROFILING
+            s << std::endl << "record timeline (T): " << Tracer::isRecording();
+            s << std::endl << "hardware counters (C): " << PerfCounters::isOpen();
+            s << std::endl << std::endl << Profiler::getSummary();
+#endif
             
             text.setString(s.str());
         }
@@ -123,6 +153,13 @@ int main(int argc, char *argv[])
 
     std::cout << "average fps: " << static_cast<float>(loops) / clock.getElapsedTime().asSeconds() << std::endl;
 
+#ifdef PROFILING
+    std::ofstream profile("profile.csv");
+    Profiler::writeCsv(profile);
+    std::cout << "phase timings written to profile.csv" << std::endl;
+    PerfCounters::close();
+#endif
+
     return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,195 @@
+#include "Advection.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "Profiler.hpp"
+#include "Simd.hpp"
+
+
+/* Size of dst, in bytes, above which it is written with non-temporal stores: it would not stay in
+ * cache until the next step reads it anyway, and streaming saves reading it in before writing it. */
+static const std::size_t STREAMING_THRESHOLD = 1 << 23;
+
+/* Where the center of a cell comes from: between the cells corner, corner+1, corner+pitch and
+ * corner+pitch+1, at (h, v) from the first one */
+struct BackTrace
+{
+    int corner;
+    float h;
+    float v;
+};
+
+/* maxCol and maxLine are the centers of the last column and line of the outer ring */
+inline BackTrace backTrace (unsigned int pitch, float maxCol, float maxLine,
+                            unsigned int line, unsigned int col, float velX, float velY, float dt)
+{
+    float prevLine = static_cast<float>(line) - dt*velY;
+    float prevCol = static_cast<float>(col) - dt*velX;
+
+    prevLine = std::min(maxLine, std::max(0.5f, prevLine));
+    prevCol = std::min(maxCol, std::max(0.5f, prevCol));
+
+    int col0 = prevCol;
+    int line0 = prevLine;
+
+    BackTrace trace;
+    trace.corner = line0*pitch + col0;
+    trace.h = prevCol - static_cast<float>(col0);
+    trace.v = prevLine - static_cast<float>(line0);
+    return trace;
+}
+
+/* Bilinear interpolation */
+inline float interpolate (float const* src, unsigned int pitch, BackTrace const& trace)
+{
+    const float h = trace.h, v = trace.v;
+    float const* corner = src + trace.corner;
+    return h   *   (v*corner[pitch+1] + (1.f-v)*corner[1]) +
+           (1.f-h)*(v*corner[pitch]   + (1.f-v)*corner[0]);
+}
+
+inline void advectCell (float const* const* srcs, float* const* dsts, unsigned int nbFields,
+                        unsigned int pitch, float maxCol, float maxLine,
+                        unsigned int line, unsigned int col, float velX, float velY, float dt)
+{
+    const BackTrace trace = backTrace(pitch, maxCol, maxLine, line, col, velX, velY, dt);
+    for (unsigned int iField = 0 ; iField < nbFields ; ++iField) {
+        dsts[iField][line*pitch + col] = interpolate(srcs[iField], pitch, trace);
+    }
+}
+
+#ifdef SIMD_ENABLED
+
+/* Advects the interior of a line, simd::WIDTH cells at a time, with the same formulas as advectCell
+ * (which does the last cells). With STREAM, vectors are written with non-temporal stores, the first
+ * cells being done one by one until the destinations are aligned (see canStream). */
+template <bool STREAM>
+static void advectLine (float const* const* srcs, float* const* dsts, unsigned int nbFields,
+                        float const* velX, float const* velY,
+                        unsigned int nbCols, unsigned int pitch, unsigned int line,
+                        float maxCol, float maxLine, float dt)
+{
+    const unsigned int end = nbCols - 1;
+    unsigned int col = 1;
+    const unsigned int offset = line*pitch;
+
+    if (STREAM) {
+        for ( ; col < end && !simd::isAligned(dsts[0] + offset + col) ; ++col) {
+            advectCell(srcs, dsts, nbFields, pitch, maxCol, maxLine, line, col, velX[offset+col], velY[offset+col], dt);
+        }
+    }
+
+    const simd::Floats dtV = simd::set(dt);
+    const simd::Floats one = simd::set(1.f);
+    const simd::Floats minPos = simd::set(0.5f);
+    const simd::Floats maxColV = simd::set(maxCol);
+    const simd::Floats maxLineV = simd::set(maxLine);
+    const simd::Floats lineV = simd::set(static_cast<float>(line));
+    const simd::Floats lanes = simd::iota();
+    const simd::Ints stride = simd::setInt(pitch);
+
+    for ( ; col + simd::WIDTH <= end ; col += simd::WIDTH) {
+        const unsigned int i = offset + col;
+        const simd::Floats colV = simd::add(simd::set(static_cast<float>(col)), lanes);
+
+        /* The bound goes second: max and min then return it for NaN velocities, as std::max/min do */
+        simd::Floats prevLine = simd::sub(lineV, simd::mul(dtV, simd::load(velY + i)));
+        simd::Floats prevCol = simd::sub(colV, simd::mul(dtV, simd::load(velX + i)));
+        prevLine = simd::min(simd::max(prevLine, minPos), maxLineV);
+        prevCol = simd::min(simd::max(prevCol, minPos), maxColV);
+
+        const simd::Ints col0 = simd::truncate(prevCol);
+        const simd::Ints line0 = simd::truncate(prevLine);
+        const simd::Floats h = simd::sub(prevCol, simd::toFloats(col0));
+        const simd::Floats v = simd::sub(prevLine, simd::toFloats(line0));
+        const simd::Floats oneMinusH = simd::sub(one, h);
+        const simd::Floats oneMinusV = simd::sub(one, v);
+        const simd::Ints corner = simd::addInt(simd::mulInt(line0, stride), col0);
+
+        for (unsigned int iField = 0 ; iField < nbFields ; ++iField) {
+            float const* src = srcs[iField];
+            const simd::Floats s00 = simd::gather(src, corner);
+            const simd::Floats s01 = simd::gather(src + 1, corner);
+            const simd::Floats s10 = simd::gather(src + pitch, corner);
+            const simd::Floats s11 = simd::gather(src + pitch + 1, corner);
+
+            const simd::Floats right = simd::add(simd::mul(v, s11), simd::mul(oneMinusV, s01));
+            const simd::Floats left = simd::add(simd::mul(v, s10), simd::mul(oneMinusV, s00));
+            const simd::Floats result = simd::add(simd::mul(h, right), simd::mul(oneMinusH, left));
+
+            if (STREAM) {
+                simd::stream(dsts[iField] + i, result);
+            } else {
+                simd::store(dsts[iField] + i, result);
+            }
+        }
+    }
+
+    for ( ; col < end ; ++col) {
+        advectCell(srcs, dsts, nbFields, pitch, maxCol, maxLine, line, col, velX[offset+col], velY[offset+col], dt);
+    }
+}
+
+/* Streaming requires the destinations to be aligned at the same cells */
+static bool canStream (float* const* dsts, unsigned int nbFields)
+{
+    const std::size_t alignment = simd::WIDTH * sizeof(float);
+    for (unsigned int iField = 1 ; iField < nbFields ; ++iField) {
+        if (reinterpret_cast<std::size_t>(dsts[iField]) % alignment != reinterpret_cast<std::size_t>(dsts[0]) % alignment)
+            return false;
+    }
+    return true;
+}
+
+#endif
+
+void advectField (BufferFloat const& src, BufferFloat& dst, BufferFloat const& velX, BufferFloat const& velY,
+                  unsigned int nbCols, unsigned int nbLines, unsigned int pitch, float dt)
+{
+    BufferFloat const* srcs[] = {&src};
+    BufferFloat* dsts[] = {&dst};
+    advectFields(srcs, dsts, 1, velX, velY, nbCols, nbLines, pitch, dt);
+}
+
+void advectFields (BufferFloat const* const* srcs, BufferFloat* const* dsts, unsigned int nbFields,
+                   BufferFloat const& velX, BufferFloat const& velY,
+                   unsigned int nbCols, unsigned int nbLines, unsigned int pitch, float dt)
+{
+    PROFILE_SCOPE_CELLS("advect", nbCols*nbLines);
+
+    if (nbFields == 0)
+        return;
+
+    std::vector<float const*> srcData(nbFields);
+    std::vector<float*> dstData(nbFields);
+    for (unsigned int iField = 0 ; iField < nbFields ; ++iField) {
+        srcData[iField] = srcs[iField]->data();
+        dstData[iField] = dsts[iField]->data();
+    }
+
+    const float maxCol = static_cast<float>(nbCols) - 1.5f;
+    const float maxLine = static_cast<float>(nbLines) - 1.5f;
+
+#ifdef SIMD_ENABLED
+    if (dsts[0]->size() * sizeof(float) > STREAMING_THRESHOLD && canStream(dstData.data(), nbFields)) {
+        for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+            advectLine<true>(srcData.data(), dstData.data(), nbFields, velX.data(), velY.data(),
+                             nbCols, pitch, line, maxCol, maxLine, dt);
+        }
+        simd::fence();
+    } else {
+        for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+            advectLine<false>(srcData.data(), dstData.data(), nbFields, velX.data(), velY.data(),
+                              nbCols, pitch, line, maxCol, maxLine, dt);
+        }
+    }
+#else
+    for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+            const unsigned int i = line*pitch + col;
+            advectCell(srcData.data(), dstData.data(), nbFields, pitch, maxCol, maxLine, line, col, velX[i], velY[i], dt);
+        }
+    }
+#endif
+}
@@ -0,0 +1,21 @@
+#include "Boundaries.hpp"
+
+
+void applyBoundaryConditions (BufferFloat& buffer, unsigned int nbCols, unsigned int nbLines, unsigned int pitch,
+                              float hFactor, float vFactor)
+{
+    for (unsigned int line=1 ; line < nbLines-1 ; ++line) {
+        buffer[line*pitch] = hFactor * buffer[line*pitch + 1];
+        buffer[line*pitch + nbCols-1] = hFactor * buffer[line*pitch + nbCols-2];
+    }
+    for (unsigned int col=1 ; col < nbCols-1 ; ++col) {
+        buffer[col] = vFactor * buffer[pitch + col];
+        buffer[(nbLines-1)*pitch + col] = vFactor * buffer[(nbLines-2)*pitch + col];
+    }
+
+    const unsigned int lastLine = (nbLines-1)*pitch;
+    buffer[0] = 0.5f * (buffer[pitch] + buffer[1]);
+    buffer[nbCols-1] = 0.5f * (buffer[pitch + nbCols-1] + buffer[nbCols-2]);
+    buffer[lastLine] = 0.5f * (buffer[lastLine - pitch] + buffer[lastLine + 1]);
+    buffer[lastLine + nbCols-1] = 0.5f * (buffer[lastLine - pitch + nbCols-1] + buffer[lastLine + nbCols-2]);
+}
@@ -0,0 +1,283 @@
+#include "ConjugateGradient.hpp"
+
+#include <cmath>
+
+#include "Boundaries.hpp"
+
+
+/* Modified incomplete Cholesky parameters (Bridson, Fluid Simulation for Computer Graphics) */
+static const float MIC_TAU = 0.97f;
+static const float MIC_SIGMA = 0.25f;
+
+ConjugateGradient::ConjugateGradient (unsigned int nbCols, unsigned int nbLines, unsigned int pitch):
+            _nbCols(nbCols),
+            _nbLines(nbLines),
+            _pitch(pitch),
+            _system(nullptr),
+            _r(pitch*nbLines, 0.f),
+            _z(pitch*nbLines, 0.f),
+            _s(pitch*nbLines, 0.f),
+            _q(pitch*nbLines, 0.f)
+{
+}
+
+SolveStats ConjugateGradient::solve (BufferFloat& x, BufferFloat const& rhs, float diag, float coupling,
+                                     float hFactor, float vFactor, Preconditioner preconditioner,
+                                     float tolerance, unsigned int maxIterations)
+{
+    prepare(diag, coupling, hFactor, vFactor, preconditioner);
+
+    SolveStats stats;
+    stats.iterations = 0;
+    stats.residual = 0.f;
+
+    /* r = rhs - A.x, from a copy of x whose ring is 0 as multiply needs it */
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            unsigned int i = line*_pitch + col;
+            _s[i] = x[i];
+        }
+    }
+    multiply(_s, _q);
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            unsigned int i = line*_pitch + col;
+            _r[i] = rhs[i] - _q[i];
+        }
+    }
+    removeMean(_r);
+
+    const double rhsNorm = std::sqrt(dot(rhs, rhs));
+    double residualNorm = std::sqrt(dot(_r, _r));
+    const double target = tolerance * rhsNorm;
+
+    if (residualNorm > target) {
+        precondition(_r, _z);
+        _s = _z;
+        double rho = dot(_r, _z);
+
+        while (stats.iterations < maxIterations) {
+            ++stats.iterations;
+
+            multiply(_s, _q);
+            const double sq = dot(_s, _q);
+            if (sq == 0.0)
+                break;
+            const float alpha = rho / sq;
+
+            for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+                for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+                    unsigned int i = line*_pitch + col;
+                    x[i] += alpha * _s[i];
+                    _r[i] -= alpha * _q[i];
+                }
+            }
+
+            residualNorm = std::sqrt(dot(_r, _r));
+            if (residualNorm <= target)
+                break;
+
+            precondition(_r, _z);
+            const double rhoNew = dot(_r, _z);
+            const float beta = rhoNew / rho;
+            rho = rhoNew;
+
+            for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+                for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+                    unsigned int i = line*_pitch + col;
+                    _s[i] = _z[i] + beta * _s[i];
+                }
+            }
+        }
+    }
+
+    applyBoundaryConditions(x, _nbCols, _nbLines, _pitch, hFactor, vFactor);
+
+    stats.residual = (rhsNorm > 0.0) ? residualNorm / rhsNorm : 0.f;
+    return stats;
+}
+
+void ConjugateGradient::prepare (float diag, float coupling, float hFactor, float vFactor, Preconditioner preconditioner)
+{
+    /* The pressure is the only singular system, the diffusions are told apart by their boundaries */
+    const bool singular = (diag == 4.f * coupling && hFactor == 1.f && vFactor == 1.f);
+    System* found = nullptr;
+    for (System& candidate : _systems) {
+        if (candidate.hFactor == hFactor && candidate.vFactor == vFactor && candidate.singular == singular) {
+            found = &candidate;
+            break;
+        }
+    }
+    if (found != nullptr && found->diag == diag && found->coupling == coupling && found->preconditioner == preconditioner) {
+        _system = found;
+        return;
+    }
+
+    if (found == nullptr) {
+        _systems.emplace_back();
+        found = &_systems.back();
+        found->matrixDiag.assign(_pitch*_nbLines, 0.f);
+        found->precon.assign(_pitch*_nbLines, 0.f);
+    }
+    System& system = *found;
+    system.diag = diag;
+    system.coupling = coupling;
+    system.hFactor = hFactor;
+    system.vFactor = vFactor;
+    system.preconditioner = preconditioner;
+    system.singular = singular;
+
+    /* A neighbour on the outer ring is the cell itself times the boundary factor */
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            float boundaries = 0.f;
+            if (col == 1)
+                boundaries += hFactor;
+            if (col == _nbCols-2)
+                boundaries += hFactor;
+            if (line == 1)
+                boundaries += vFactor;
+            if (line == _nbLines-2)
+                boundaries += vFactor;
+
+            system.matrixDiag[line*_pitch + col] = diag - coupling * boundaries;
+        }
+    }
+
+    if (preconditioner == Preconditioner::JACOBI) {
+        for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+            for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+                unsigned int i = line*_pitch + col;
+                system.precon[i] = 1.f / system.matrixDiag[i];
+            }
+        }
+    } else {
+        buildIncompleteCholesky(system);
+    }
+
+    _system = &system;
+}
+
+/* MIC(0) pivots of the matrix of system */
+void ConjugateGradient::buildIncompleteCholesky (System& system) const
+{
+    /* Off-diagonal terms are -coupling between two interior cells */
+    const float offDiag = -system.coupling;
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            unsigned int i = line*_pitch + col;
+            float e = system.matrixDiag[i];
+            float modification = 0.f;
+
+            if (col > 1) {
+                float p = system.precon[i-1];
+                e -= (offDiag * p) * (offDiag * p);
+                if (line < _nbLines-2)
+                    modification += offDiag * offDiag * p * p;
+            }
+            if (line > 1) {
+                float p = system.precon[i-_pitch];
+                e -= (offDiag * p) * (offDiag * p);
+                if (col < _nbCols-2)
+                    modification += offDiag * offDiag * p * p;
+            }
+
+            e -= MIC_TAU * modification;
+            if (e < MIC_SIGMA * system.matrixDiag[i])
+                e = system.matrixDiag[i];
+
+            system.precon[i] = 1.f / std::sqrt(e);
+        }
+    }
+}
+
+/* The matrix has no term on the outer ring, where s is 0: the neighbours are summed without a test */
+void ConjugateGradient::multiply (BufferFloat const& s, BufferFloat& q) const
+{
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            unsigned int i = line*_pitch + col;
+
+            const float neighbours = s[i-1] + s[i+1] + s[i-_pitch] + s[i+_pitch];
+            q[i] = _system->matrixDiag[i] * s[i] - _system->coupling * neighbours;
+        }
+    }
+}
+
+void ConjugateGradient::precondition (BufferFloat const& r, BufferFloat& z)
+{
+    if (_system->preconditioner == Preconditioner::JACOBI) {
+        for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+            for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+                unsigned int i = line*_pitch + col;
+                z[i] = _system->precon[i] * r[i];
+            }
+        }
+    } else {
+        applyIncompleteCholesky(r, z);
+    }
+
+    removeMean(z);
+}
+
+void ConjugateGradient::applyIncompleteCholesky (BufferFloat const& r, BufferFloat& z) const
+{
+    const float offDiag = -_system->coupling;
+
+    /* Neither the pivots nor z are ever written on the outer ring, which stays 0: the terms
+     * coming from outside the interior vanish without a test */
+
+    /* Solves L.q = r, q being stored in z */
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            unsigned int i = line*_pitch + col;
+            float t = r[i];
+            t -= offDiag * _system->precon[i-1] * z[i-1];
+            t -= offDiag * _system->precon[i-_pitch] * z[i-_pitch];
+            z[i] = t * _system->precon[i];
+        }
+    }
+
+    /* Solves L^T.z = q */
+    for (unsigned int line = _nbLines-2 ; line >= 1 ; --line) {
+        for (unsigned int col = _nbCols-2 ; col >= 1 ; --col) {
+            unsigned int i = line*_pitch + col;
+            float t = z[i];
+            t -= offDiag * _system->precon[i] * z[i+1];
+            t -= offDiag * _system->precon[i] * z[i+_pitch];
+            z[i] = t * _system->precon[i];
+        }
+    }
+}
+
+double ConjugateGradient::dot (BufferFloat const& a, BufferFloat const& b) const
+{
+    double sum = 0.0;
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            unsigned int i = line*_pitch + col;
+            sum += a[i] * b[i];
+        }
+    }
+    return sum;
+}
+
+void ConjugateGradient::removeMean (BufferFloat& r) const
+{
+    if (!_system->singular)
+        return;
+
+    double sum = 0.0;
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            sum += r[line*_pitch + col];
+        }
+    }
+
+    const float mean = sum / static_cast<double>((_nbCols-2) * (_nbLines-2));
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            r[line*_pitch + col] -= mean;
+        }
+    }
+}
@@ -0,0 +1,379 @@
+#include "Dct.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+Dct::Dct (unsigned int n):
+            _n(n),
+            _maxFactor(1),
+            _rootsRe(n),
+            _rootsIm(n),
+            _shiftRe(n),
+            _shiftIm(n)
+{
+    /* Radix 4 first, it needs the fewest operations per point */
+    unsigned int remaining = n;
+    while (remaining % 4 == 0) {
+        _factors.push_back(4);
+        remaining /= 4;
+    }
+    for (unsigned int factor = 2 ; remaining > 1 ; ++factor) {
+        while (remaining % factor == 0) {
+            _factors.push_back(factor);
+            remaining /= factor;
+        }
+    }
+    for (unsigned int factor : _factors) {
+        _maxFactor = std::max(_maxFactor, factor);
+    }
+
+    const double pi = 3.14159265358979323846;
+    for (unsigned int k = 0 ; k < n ; ++k) {
+        _rootsRe[k] = std::cos(-2.0 * pi * k / n);
+        _rootsIm[k] = std::sin(-2.0 * pi * k / n);
+        _shiftRe[k] = std::cos(-0.5 * pi * k / n);
+        _shiftIm[k] = std::sin(-0.5 * pi * k / n);
+    }
+
+    if (_maxFactor > MAX_PRIME_FACTOR) {
+        _factors.clear();
+        _maxFactor = 1;
+
+        unsigned int m = 1;
+        while (m < 2*n - 1) {
+            m *= 2;
+        }
+        _convolution.reset(new Dct(m));
+
+        /* k^2 modulo 2n keeps the angles accurate on long transforms */
+        _chirpRe.resize(n);
+        _chirpIm.resize(n);
+        for (unsigned int k = 0 ; k < n ; ++k) {
+            const unsigned long long square = static_cast<unsigned long long>(k) * k % (2*n);
+            _chirpRe[k] = std::cos(-pi * square / n);
+            _chirpIm[k] = std::sin(-pi * square / n);
+        }
+
+        _kernelRe.assign(m, 0.f);
+        _kernelIm.assign(m, 0.f);
+        for (unsigned int k = 0 ; k < n ; ++k) {
+            _kernelRe[k] = _chirpRe[k] / m;
+            _kernelIm[k] = -_chirpIm[k] / m;
+            if (k > 0) {
+                _kernelRe[m-k] = _kernelRe[k];
+                _kernelIm[m-k] = _kernelIm[k];
+            }
+        }
+        std::vector<float> scratch(_convolution->getScratchSize(1));
+        _convolution->fft(_kernelRe.data(), _kernelIm.data(), scratch.data(), 1);
+    }
+}
+
+unsigned int Dct::getSize() const
+{
+    return _n;
+}
+
+std::size_t Dct::getWorkspaceSize (unsigned int batch) const
+{
+    return 2*_n*batch + getScratchSize(batch);
+}
+
+void Dct::forward (float* data, unsigned int batch, float* workspace) const
+{
+    float* re = workspace;
+    float* im = re + _n*batch;
+    float* scratch = im + _n*batch;
+
+    /* Even samples in increasing order, then odd samples in decreasing order */
+    for (unsigned int k = 0 ; 2*k < _n ; ++k) {
+        std::copy(data + 2*k*batch, data + (2*k+1)*batch, re + k*batch);
+    }
+    for (unsigned int k = 0 ; 2*k+1 < _n ; ++k) {
+        std::copy(data + (2*k+1)*batch, data + (2*k+2)*batch, re + (_n-1-k)*batch);
+    }
+    std::fill(im, im + _n*batch, 0.f);
+
+    fft(re, im, scratch, batch);
+
+    /* X[k] = Re(exp(-i*pi*k/(2n)) * V[k]) */
+    for (unsigned int k = 0 ; k < _n ; ++k) {
+        const float wRe = _shiftRe[k], wIm = _shiftIm[k];
+        float* x = data + k*batch;
+        float const* vRe = re + k*batch;
+        float const* vIm = im + k*batch;
+        for (unsigned int b = 0 ; b < batch ; ++b) {
+            x[b] = wRe * vRe[b] - wIm * vIm[b];
+        }
+    }
+}
+
+void Dct::inverse (float* data, unsigned int batch, float* workspace) const
+{
+    float* re = workspace;
+    float* im = re + _n*batch;
+    float* scratch = im + _n*batch;
+
+    /* conj(V[k]) = exp(-i*pi*k/(2n)) * (X[k] + i*X[n-k]), with X[n] = 0.
+     * The inverse FFT of V is the conjugate of the FFT of conj(V), divided by n. */
+    for (unsigned int k = 0 ; k < _n ; ++k) {
+        const float wRe = _shiftRe[k], wIm = _shiftIm[k];
+        float const* x = data + k*batch;
+        float* vRe = re + k*batch;
+        float* vIm = im + k*batch;
+        if (k == 0) {
+            for (unsigned int b = 0 ; b < batch ; ++b) {
+                vRe[b] = x[b];
+                vIm[b] = 0.f;
+            }
+        } else {
+            float const* xMirror = data + (_n-k)*batch;
+            for (unsigned int b = 0 ; b < batch ; ++b) {
+                vRe[b] = wRe * x[b] - wIm * xMirror[b];
+                vIm[b] = wIm * x[b] + wRe * xMirror[b];
+            }
+        }
+    }
+
+    fft(re, im, scratch, batch);
+
+    const float scale = 1.f / static_cast<float>(_n);
+    for (unsigned int k = 0 ; 2*k < _n ; ++k) {
+        float* x = data + 2*k*batch;
+        float const* v = re + k*batch;
+        for (unsigned int b = 0 ; b < batch ; ++b) {
+            x[b] = scale * v[b];
+        }
+    }
+    for (unsigned int k = 0 ; 2*k+1 < _n ; ++k) {
+        float* x = data + (2*k+1)*batch;
+        float const* v = re + (_n-1-k)*batch;
+        for (unsigned int b = 0 ; b < batch ; ++b) {
+            x[b] = scale * v[b];
+        }
+    }
+}
+
+std::size_t Dct::getScratchSize (unsigned int batch) const
+{
+    if (_convolution)
+        return 2*_convolution->getSize()*batch + _convolution->getScratchSize(batch);
+    return (2*_n + 2*_maxFactor) * batch;
+}
+
+void Dct::fft (float* re, float* im, float* scratch, unsigned int batch) const
+{
+    if (_convolution) {
+        bluestein(re, im, scratch, batch);
+    } else {
+        float* tmpIm = scratch + _n*batch;
+        mixedRadix(re, im, scratch, tmpIm, tmpIm + _n*batch, batch);
+    }
+}
+
+void Dct::mixedRadix (float* re, float* im, float* tmpRe, float* tmpIm, float* butterfly, unsigned int batch) const
+{
+    float* inRe = re;
+    float* inIm = im;
+    float* outRe = tmpRe;
+    float* outIm = tmpIm;
+
+    unsigned int ns = 1;
+    for (unsigned int radix : _factors) {
+        const unsigned int nbButterflies = _n / radix;
+        for (unsigned int j = 0 ; j < nbButterflies ; ++j) {
+            if (radix == 4) {
+                radix4(inRe, inIm, outRe, outIm, j, ns, batch);
+            } else if (radix == 2) {
+                radix2(inRe, inIm, outRe, outIm, j, ns, batch);
+            } else {
+                radixGeneric(inRe, inIm, outRe, outIm, radix, j, ns, batch, butterfly);
+            }
+        }
+
+        std::swap(inRe, outRe);
+        std::swap(inIm, outIm);
+        ns *= radix;
+    }
+
+    if (inRe != re) {
+        std::copy(inRe, inRe + _n*batch, re);
+        std::copy(inIm, inIm + _n*batch, im);
+    }
+}
+
+void Dct::bluestein (float* re, float* im, float* scratch, unsigned int batch) const
+{
+    const unsigned int m = _convolution->getSize();
+    float* aRe = scratch;
+    float* aIm = aRe + m*batch;
+
+    for (unsigned int k = 0 ; k < _n ; ++k) {
+        const float wRe = _chirpRe[k], wIm = _chirpIm[k];
+        float const* xRe = re + k*batch;
+        float const* xIm = im + k*batch;
+        for (unsigned int b = 0 ; b < batch ; ++b) {
+            aRe[k*batch + b] = wRe * xRe[b] - wIm * xIm[b];
+            aIm[k*batch + b] = wRe * xIm[b] + wIm * xRe[b];
+        }
+    }
+    std::fill(aRe + _n*batch, aRe + m*batch, 0.f);
+    std::fill(aIm + _n*batch, aIm + m*batch, 0.f);
+
+    _convolution->fft(aRe, aIm, aIm + m*batch, batch);
+
+    /* Product with the kernel, conjugated: the inverse FFT is the conjugate of the FFT of the conjugate */
+    for (unsigned int k = 0 ; k < m ; ++k) {
+        const float kRe = _kernelRe[k], kIm = _kernelIm[k];
+        float* yRe = aRe + k*batch;
+        float* yIm = aIm + k*batch;
+        for (unsigned int b = 0 ; b < batch ; ++b) {
+            const float productRe = kRe * yRe[b] - kIm * yIm[b];
+            const float productIm = kRe * yIm[b] + kIm * yRe[b];
+            yRe[b] = productRe;
+            yIm[b] = -productIm;
+        }
+    }
+
+    _convolution->fft(aRe, aIm, aIm + m*batch, batch);
+
+    for (unsigned int k = 0 ; k < _n ; ++k) {
+        const float wRe = _chirpRe[k], wIm = _chirpIm[k];
+        float const* cRe = aRe + k*batch;
+        float const* cIm = aIm + k*batch;
+        float* xRe = re + k*batch;
+        float* xIm = im + k*batch;
+        for (unsigned int b = 0 ; b < batch ; ++b) {
+            xRe[b] = wRe * cRe[b] + wIm * cIm[b];
+            xIm[b] = wIm * cRe[b] - wRe * cIm[b];
+        }
+    }
+}
+
+void Dct::radix2 (float const* inRe, float const* inIm, float* outRe, float* outIm,
+                  unsigned int j, unsigned int ns, unsigned int batch) const
+{
+    const unsigned int m = _n / 2;
+    const unsigned int k = j % ns;
+    const unsigned int twiddle = k * (_n / (2*ns));
+    const float w1Re = _rootsRe[twiddle], w1Im = _rootsIm[twiddle];
+
+    float const* a0Re = inRe + j*batch;
+    float const* a0Im = inIm + j*batch;
+    float const* a1Re = inRe + (j+m)*batch;
+    float const* a1Im = inIm + (j+m)*batch;
+
+    const unsigned int out = (j/ns)*ns*2 + k;
+    float* y0Re = outRe + out*batch;
+    float* y0Im = outIm + out*batch;
+    float* y1Re = outRe + (out+ns)*batch;
+    float* y1Im = outIm + (out+ns)*batch;
+
+    for (unsigned int b = 0 ; b < batch ; ++b) {
+        float t1Re = w1Re * a1Re[b] - w1Im * a1Im[b];
+        float t1Im = w1Re * a1Im[b] + w1Im * a1Re[b];
+
+        y0Re[b] = a0Re[b] + t1Re;
+        y0Im[b] = a0Im[b] + t1Im;
+        y1Re[b] = a0Re[b] - t1Re;
+        y1Im[b] = a0Im[b] - t1Im;
+    }
+}
+
+void Dct::radix4 (float const* inRe, float const* inIm, float* outRe, float* outIm,
+                  unsigned int j, unsigned int ns, unsigned int batch) const
+{
+    const unsigned int m = _n / 4;
+    const unsigned int k = j % ns;
+    const unsigned int twiddle = k * (_n / (4*ns));
+    const float w1Re = _rootsRe[twiddle], w1Im = _rootsIm[twiddle];
+    const float w2Re = _rootsRe[2*twiddle], w2Im = _rootsIm[2*twiddle];
+    const float w3Re = _rootsRe[3*twiddle], w3Im = _rootsIm[3*twiddle];
+
+    float const* a0Re = inRe + j*batch;
+    float const* a0Im = inIm + j*batch;
+    float const* a1Re = inRe + (j+m)*batch;
+    float const* a1Im = inIm + (j+m)*batch;
+    float const* a2Re = inRe + (j+2*m)*batch;
+    float const* a2Im = inIm + (j+2*m)*batch;
+    float const* a3Re = inRe + (j+3*m)*batch;
+    float const* a3Im = inIm + (j+3*m)*batch;
+
+    const unsigned int out = (j/ns)*ns*4 + k;
+    float* y0Re = outRe + out*batch;
+    float* y0Im = outIm + out*batch;
+    float* y1Re = outRe + (out+ns)*batch;
+    float* y1Im = outIm + (out+ns)*batch;
+    float* y2Re = outRe + (out+2*ns)*batch;
+    float* y2Im = outIm + (out+2*ns)*batch;
+    float* y3Re = outRe + (out+3*ns)*batch;
+    float* y3Im = outIm + (out+3*ns)*batch;
+
+    for (unsigned int b = 0 ; b < batch ; ++b) {
+        float b1Re = w1Re * a1Re[b] - w1Im * a1Im[b];
+        float b1Im = w1Re * a1Im[b] + w1Im * a1Re[b];
+        float b2Re = w2Re * a2Re[b] - w2Im * a2Im[b];
+        float b2Im = w2Re * a2Im[b] + w2Im * a2Re[b];
+        float b3Re = w3Re * a3Re[b] - w3Im * a3Im[b];
+        float b3Im = w3Re * a3Im[b] + w3Im * a3Re[b];
+
+        float t0Re = a0Re[b] + b2Re, t0Im = a0Im[b] + b2Im;
+        float t1Re = a0Re[b] - b2Re, t1Im = a0Im[b] - b2Im;
+        float t2Re = b1Re + b3Re, t2Im = b1Im + b3Im;
+        float t3Re = b1Re - b3Re, t3Im = b1Im - b3Im;
+
+        /* exp(-2i*pi/4) = -i */
+        y0Re[b] = t0Re + t2Re;
+        y0Im[b] = t0Im + t2Im;
+        y1Re[b] = t1Re + t3Im;
+        y1Im[b] = t1Im - t3Re;
+        y2Re[b] = t0Re - t2Re;
+        y2Im[b] = t0Im - t2Im;
+        y3Re[b] = t1Re - t3Im;
+        y3Im[b] = t1Im + t3Re;
+    }
+}
+
+void Dct::radixGeneric (float const* inRe, float const* inIm, float* outRe, float* outIm,
+                        unsigned int radix, unsigned int j, unsigned int ns, unsigned int batch,
+                        float* butterfly) const
+{
+    const unsigned int m = _n / radix;
+    const unsigned int k = j % ns;
+    const unsigned int twiddle = k * (_n / (radix*ns));
+    const unsigned int rootStep = _n / radix;
+
+    /* Twiddled inputs */
+    float* aRe = butterfly;
+    float* aIm = butterfly + radix*batch;
+    for (unsigned int r = 0 ; r < radix ; ++r) {
+        const float wRe = _rootsRe[r*twiddle], wIm = _rootsIm[r*twiddle];
+        float const* xRe = inRe + (j + r*m)*batch;
+        float const* xIm = inIm + (j + r*m)*batch;
+        for (unsigned int b = 0 ; b < batch ; ++b) {
+            aRe[r*batch + b] = wRe * xRe[b] - wIm * xIm[b];
+            aIm[r*batch + b] = wRe * xIm[b] + wIm * xRe[b];
+        }
+    }
+
+    /* Direct DFT of size radix */
+    const unsigned int out = (j/ns)*ns*radix + k;
+    for (unsigned int q = 0 ; q < radix ; ++q) {
+        float* yRe = outRe + (out + q*ns)*batch;
+        float* yIm = outIm + (out + q*ns)*batch;
+        std::copy(aRe, aRe + batch, yRe);
+        std::copy(aIm, aIm + batch, yIm);
+
+        for (unsigned int r = 1 ; r < radix ; ++r) {
+            const unsigned int root = ((r*q) % radix) * rootStep;
+            const float wRe = _rootsRe[root], wIm = _rootsIm[root];
+            float const* xRe = aRe + r*batch;
+            float const* xIm = aIm + r*batch;
+            for (unsigned int b = 0 ; b < batch ; ++b) {
+                yRe[b] += wRe * xRe[b] - wIm * xIm[b];
+                yIm[b] += wRe * xIm[b] + wIm * xRe[b];
+            }
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#include "FieldArena.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+
+/* Size of the huge pages, which the transparent ones are aligned on */
+static const std::size_t HUGE_PAGE_SIZE = 2 << 20;
+
+static std::size_t roundUp (std::size_t size, std::size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+bool parseHugePages (std::string const& name, HugePages& hugePages)
+{
+    if (name == "none") {
+        hugePages = HugePages::NONE;
+    } else if (name == "transparent") {
+        hugePages = HugePages::TRANSPARENT;
+    } else if (name == "explicit") {
+        hugePages = HugePages::EXPLICIT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string getHugePagesName (HugePages hugePages)
+{
+    const char* names[] = {"none", "transparent", "explicit"};
+    return names[static_cast<int>(hugePages)];
+}
+
+FieldArena::FieldArena (std::size_t capacity, HugePages hugePages):
+            _memory(nullptr),
+            _mappedSize(0),
+            _capacity(roundUp(capacity, ALIGNMENT)),
+            _used(0),
+            _hugePages(HugePages::NONE)
+{
+    if (_capacity == 0)
+        return;
+
+#ifdef __linux__
+#ifdef MAP_HUGETLB
+    if (hugePages == HugePages::EXPLICIT) {
+        const std::size_t size = roundUp(_capacity, HUGE_PAGE_SIZE);
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            _memory = static_cast<unsigned char*>(memory);
+            _mappedSize = size;
+            _hugePages = HugePages::EXPLICIT;
+            return;
+        }
+        /* None reserved (/proc/sys/vm/nr_hugepages): transparent ones are the next best thing */
+        hugePages = HugePages::TRANSPARENT;
+    }
+#endif
+
+    /* Transparent huge pages only back 2 MB aligned ranges: map more, then trim to an aligned range */
+    const bool transparent = (hugePages != HugePages::NONE);
+    const std::size_t size = transparent ? roundUp(_capacity, HUGE_PAGE_SIZE) : _capacity;
+    const std::size_t slack = transparent ? HUGE_PAGE_SIZE : 0;
+    void* memory = mmap(nullptr, size + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+        unsigned char* begin = static_cast<unsigned char*>(memory);
+        unsigned char* aligned = begin;
+        if (transparent) {
+            aligned = begin + (HUGE_PAGE_SIZE - reinterpret_cast<std::size_t>(begin) % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+            if (aligned > begin) {
+                munmap(begin, aligned - begin);
+            }
+            if (begin + size + slack > aligned + size) {
+                munmap(aligned + size, begin + size + slack - (aligned + size));
+            }
+#ifdef MADV_HUGEPAGE
+            if (madvise(aligned, size, MADV_HUGEPAGE) == 0) {
+                _hugePages = HugePages::TRANSPARENT;
+            }
+#endif
+        }
+        _memory = aligned;
+        _mappedSize = size;
+        return;
+    }
+#else
+    (void) hugePages;
+#endif
+
+    _memory = static_cast<unsigned char*>(allocateStandalone(_capacity));
+}
+
+FieldArena::~FieldArena()
+{
+#ifdef __linux__
+    if (_mappedSize > 0) {
+        munmap(_memory, _mappedSize);
+        return;
+    }
+#endif
+    freeStandalone(_memory);
+}
+
+void* FieldArena::allocate (std::size_t size)
+{
+    size = roundUp(size, ALIGNMENT);
+    if (_memory == nullptr || size > _capacity - _used)
+        return nullptr;
+
+    void* memory = _memory + _used;
+    _used += size;
+    return memory;
+}
+
+bool FieldArena::contains (void const* memory) const
+{
+    unsigned char const* p = static_cast<unsigned char const*>(memory);
+    return _memory != nullptr && p >= _memory && p < _memory + _capacity;
+}
+
+HugePages FieldArena::getHugePages() const
+{
+    return _hugePages;
+}
+
+std::size_t FieldArena::getCapacity() const
+{
+    return _capacity;
+}
+
+std::size_t FieldArena::getUsed() const
+{
+    return _used;
+}
+
+void* FieldArena::allocateStandalone (std::size_t size)
+{
+    void* memory = nullptr;
+    if (posix_memalign(&memory, ALIGNMENT, roundUp(size, ALIGNMENT)) != 0)
+        throw std::bad_alloc();
+
+    std::memset(memory, 0, size);
+    return memory;
+}
+
+void FieldArena::freeStandalone (void* memory)
+{
+    std::free(memory);
+}
@@ -0,0 +1,703 @@
+#include "FluidSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Advection.hpp"
+#include "Boundaries.hpp"
+#include "ConjugateGradient.hpp"
+#include "GaussSeidel.hpp"
+#include "Multigrid.hpp"
+#include "Profiler.hpp"
+#include "SpectralPoisson.hpp"
+
+
+/* Square grid sizes with kernels of their own (see getFixedSize) */
+static const unsigned int FIXED_SIZES[] = {128, 256, 512, 1024};
+
+unsigned int getFixedSize (unsigned int nbCols, unsigned int nbLines, unsigned int pitch)
+{
+    for (unsigned int size : FIXED_SIZES) {
+        if (nbCols == size && nbLines == size && (pitch == size || pitch == getPaddedPitch(size)))
+            return size;
+    }
+    return 0;
+}
+
+inline int nextBuffer(int currBuffer)
+{
+    return (currBuffer + 1) % 2;
+}
+
+/* Number of threads of the parallel regions started by the calling thread, until the end of the scope.
+ * 0 keeps the current number. */
+class ThreadCountScope
+{
+    public:
+        explicit ThreadCountScope (unsigned int nbThreads)
+        {
+#ifdef _OPENMP
+            _previous = omp_get_max_threads();
+            if (nbThreads > 0) {
+                omp_set_num_threads(nbThreads);
+            }
+#else
+            (void) nbThreads;
+#endif
+        }
+
+        ~ThreadCountScope()
+        {
+#ifdef _OPENMP
+            omp_set_num_threads(_previous);
+#endif
+        }
+
+    private:
+        int _previous;
+};
+
+/* Fields of the arena: density, velocity and their scratch buffers, and the warm start pressures */
+static const unsigned int NB_ARENA_FIELDS = 8;
+
+/* Room taken in the arena by one field */
+static std::size_t getFieldBytes (unsigned int pitch, unsigned int nbLines)
+{
+    const std::size_t bytes = pitch * nbLines * sizeof(float);
+    return (bytes + FieldArena::ALIGNMENT - 1) / FieldArena::ALIGNMENT * FieldArena::ALIGNMENT;
+}
+
+FluidSolver::FluidSolver (unsigned int nbCols, unsigned int nbLines, float visc, HugePages hugePages,
+                          RowPitch rowPitch):
+            _nbLines(nbLines),
+            _nbCols(nbCols),
+            _pitch((rowPitch == RowPitch::PADDED) ? getPaddedPitch(nbCols) : nbCols),
+            _arena(new FieldArena(NB_ARENA_FIELDS * getFieldBytes(_pitch, nbLines), hugePages)),
+            _currDensity(0),
+            _currVel(0),
+            _pressureSolver(LinearSolver::GAUSS_SEIDEL),
+            _diffusionSolver(LinearSolver::GAUSS_SEIDEL),
+            _warmStart(false),
+            _fusedDensityAdvection(false),
+            _nbThreads(0),
+            _multigridCycles(2),
+            _preconditioner(Preconditioner::MIC),
+            _tolerance(1e-3f),
+            _maxIterations(200),
+            _viscosity(visc)
+{
+    allocateField(_densities[0]);
+    allocateField(_densities[1]);
+    
+    allocateField(_velX[0]);
+    allocateField(_velX[1]);
+    
+    allocateField(_velY[0]);
+    allocateField(_velY[1]);
+
+    _pressureStats.iterations = 0;
+    _pressureStats.residual = 0.f;
+    _diffusionStats = _pressureStats;
+
+    _relaxation.ordering = SweepOrdering::LEXICOGRAPHIC;
+    _relaxation.tolerance = 0.f;
+    _relaxation.checkInterval = 4;
+    _relaxation.maxSweeps = 20;
+    _relaxation.sweepsPerPass = 8;
+}
+
+FluidSolver::~FluidSolver()
+{
+}
+
+unsigned int FluidSolver::getNbCols() const
+{
+    return _nbCols;
+}
+
+unsigned int FluidSolver::getNbLines() const
+{
+    return _nbLines;
+}
+
+unsigned int FluidSolver::getPitch() const
+{
+    return _pitch;
+}
+
+HugePages FluidSolver::getHugePages() const
+{
+    return _arena->getHugePages();
+}
+
+void FluidSolver::allocateField (BufferFloat& buffer)
+{
+    buffer = BufferFloat(FieldAllocator<float>(_arena.get()));
+    buffer.resize(_pitch*_nbLines);
+}
+
+BufferFloat const& FluidSolver::getDensities() const
+{
+    return _densities[_currDensity];
+}
+
+BufferFloat const& FluidSolver::getVelX() const
+{
+    return _velX[_currVel];
+}
+
+BufferFloat const& FluidSolver::getVelY() const
+{
+    return _velY[_currVel];
+}
+
+BufferFloat const& FluidSolver::getScalar (unsigned int scalar) const
+{
+    return _scalars[scalar][0];
+}
+
+void FluidSolver::setViscosity (float viscosity)
+{
+    _viscosity = viscosity;
+}
+
+float FluidSolver::getViscosity() const
+{
+    return _viscosity;
+}
+
+void FluidSolver::setPressureSolver (LinearSolver solver)
+{
+    _pressureSolver = solver;
+}
+
+void FluidSolver::setDiffusionSolver (LinearSolver solver)
+{
+    _diffusionSolver = solver;
+}
+
+LinearSolver FluidSolver::getPressureSolver() const
+{
+    return _pressureSolver;
+}
+
+LinearSolver FluidSolver::getDiffusionSolver() const
+{
+    return _diffusionSolver;
+}
+
+void FluidSolver::setMultigridCycles (unsigned int nbCycles)
+{
+    _multigridCycles = nbCycles;
+}
+
+void FluidSolver::setPreconditioner (Preconditioner preconditioner)
+{
+    _preconditioner = preconditioner;
+}
+
+void FluidSolver::setTolerance (float tolerance)
+{
+    _tolerance = tolerance;
+}
+
+void FluidSolver::setMaxIterations (unsigned int maxIterations)
+{
+    _maxIterations = maxIterations;
+}
+
+void FluidSolver::setRelaxationTolerance (float tolerance)
+{
+    _relaxation.tolerance = tolerance;
+}
+
+void FluidSolver::setRelaxationCheckInterval (unsigned int checkInterval)
+{
+    _relaxation.checkInterval = checkInterval;
+}
+
+void FluidSolver::setRelaxationMaxSweeps (unsigned int maxSweeps)
+{
+    _relaxation.maxSweeps = maxSweeps;
+}
+
+void FluidSolver::setRelaxationOrdering (SweepOrdering ordering)
+{
+    _relaxation.ordering = ordering;
+}
+
+void FluidSolver::setRelaxationBlocking (unsigned int sweepsPerPass)
+{
+    _relaxation.sweepsPerPass = sweepsPerPass;
+}
+
+void FluidSolver::setWarmStart (bool warmStart)
+{
+    _warmStart = warmStart;
+}
+
+bool FluidSolver::getWarmStart() const
+{
+    return _warmStart;
+}
+
+void FluidSolver::setFusedDensityAdvection (bool fused)
+{
+    _fusedDensityAdvection = fused;
+}
+
+bool FluidSolver::getFusedDensityAdvection() const
+{
+    return _fusedDensityAdvection;
+}
+
+void FluidSolver::setNbThreads (unsigned int nbThreads)
+{
+    _nbThreads = nbThreads;
+}
+
+unsigned int FluidSolver::getNbThreads() const
+{
+    return _nbThreads;
+}
+
+SolveStats const& FluidSolver::getPressureStats() const
+{
+    return _pressureStats;
+}
+
+SolveStats const& FluidSolver::getDiffusionStats() const
+{
+    return _diffusionStats;
+}
+
+void FluidSolver::reset()
+{
+    for (int i = 0 ; i <= 1 ; ++i) {
+        std::fill(_densities[i].begin(), _densities[i].end(), 0.f);
+        std::fill(_velX[i].begin(), _velX[i].end(), 0.f);
+        std::fill(_velY[i].begin(), _velY[i].end(), 0.f);
+        std::fill(_pressures[i].begin(), _pressures[i].end(), 0.f);
+        for (std::array<BufferFloat, 2>& scalar : _scalars) {
+            std::fill(scalar[i].begin(), scalar[i].end(), 0.f);
+        }
+    }
+}
+
+void FluidSolver::addDensity (glm::vec2 pos, float radius, float strength)
+{
+    PROFILE_SCOPE("splat");
+
+    BufferFloat& oldDensities = _densities[_currDensity];
+    BufferFloat& newDensities = _densities[nextBuffer(_currDensity)];
+
+    float cCol = pos.y;
+    float cLine = pos.x;
+
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            int currIndex = index(line,col);
+
+            float fLine = (float)(line) / (float)_nbLines;
+            float fCol = (float)(col) / (float)_nbCols;
+            float distSq = (fLine-cLine)*(fLine-cLine) + (fCol-cCol)*(fCol-cCol);
+
+            float perturbation = (distSq < radius) ? strength : 0.f;
+            
+            newDensities[currIndex] = oldDensities[currIndex] + perturbation;
+
+            newDensities[currIndex] = std::min(1.f, newDensities[currIndex]);
+        }
+    }
+
+    _currDensity = nextBuffer(_currDensity);
+}
+
+unsigned int FluidSolver::addScalar()
+{
+    _scalars.emplace_back();
+    allocateField(_scalars.back()[0]);
+    allocateField(_scalars.back()[1]);
+    return _scalars.size() - 1;
+}
+
+unsigned int FluidSolver::getNbScalars() const
+{
+    return _scalars.size();
+}
+
+void FluidSolver::addScalarSource (unsigned int scalar, glm::vec2 pos, float radius, float strength)
+{
+    PROFILE_SCOPE("splat");
+
+    BufferFloat& values = _scalars[scalar][0];
+
+    float cCol = pos.y;
+    float cLine = pos.x;
+
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            float fLine = (float)(line) / (float)_nbLines;
+            float fCol = (float)(col) / (float)_nbCols;
+            float distSq = (fLine-cLine)*(fLine-cLine) + (fCol-cCol)*(fCol-cCol);
+
+            if (distSq < radius) {
+                values[index(line,col)] += strength;
+            }
+        }
+    }
+}
+
+void FluidSolver::addVelocity (glm::vec2 pos, glm::vec2 dir)
+{
+    PROFILE_SCOPE("splat");
+
+    BufferFloat& oldVelX = _velX[_currVel];
+    BufferFloat& oldVelY = _velY[_currVel];
+    BufferFloat& newVelX = _velX[nextBuffer(_currVel)];
+    BufferFloat& newVelY = _velY[nextBuffer(_currVel)];
+
+    float radius = 0.002f;
+    float cCol = pos.y;
+    float cLine = pos.x;
+
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            int currIndex = index(line,col);
+
+            float fLine = (float)(line) / (float)_nbLines;
+            float fCol = (float)(col) / (float)_nbCols;
+            float distSq = (fLine-cLine)*(fLine-cLine) + (fCol-cCol)*(fCol-cCol);
+
+            glm::vec2 perturbation = (distSq < radius) ? 1000.f*glm::vec2(dir.y, dir.x) : glm::vec2(0.f, 0.f);
+            
+            newVelX[currIndex] = oldVelX[currIndex] + perturbation.x;
+            newVelY[currIndex] = oldVelY[currIndex] + perturbation.y;
+        }
+    }
+
+    _currVel = nextBuffer(_currVel);
+}
+
+void FluidSolver::update (float dt)
+{
+    PROFILE_SCOPE_CELLS("update", _nbCols*_nbLines);
+    const ThreadCountScope threads(_nbThreads);
+
+    _pressureStats.iterations = 0;
+    _pressureStats.residual = 0.f;
+    _diffusionStats = _pressureStats;
+
+    solveDensity(dt);
+    solveVelocity(dt);
+}
+
+void FluidSolver::setState (BufferFloat const& densities, BufferFloat const& velX, BufferFloat const& velY)
+{
+    _densities[_currDensity] = densities;
+    _velX[_currVel] = velX;
+    _velY[_currVel] = velY;
+}
+
+void FluidSolver::diffuseDensity (float dt)
+{
+    const ThreadCountScope threads(_nbThreads);
+    diffuse<DensityBoundaries>(_densities[_currDensity], _densities[nextBuffer(_currDensity)], dt);
+    _currDensity = nextBuffer(_currDensity);
+}
+
+void FluidSolver::advectDensity (float dt)
+{
+    const ThreadCountScope threads(_nbThreads);
+    advectField(_densities[_currDensity], _densities[nextBuffer(_currDensity)], _velX[_currVel], _velY[_currVel],
+                _nbCols, _nbLines, _pitch, dt);
+    _currDensity = nextBuffer(_currDensity);
+}
+
+void FluidSolver::advectVelocity (float dt)
+{
+    const ThreadCountScope threads(_nbThreads);
+    BufferFloat const* srcs[] = {&_velX[_currVel], &_velY[_currVel]};
+    BufferFloat* dsts[] = {&_velX[nextBuffer(_currVel)], &_velY[nextBuffer(_currVel)]};
+    advectFields(srcs, dsts, 2, _velX[_currVel], _velY[_currVel], _nbCols, _nbLines, _pitch, dt);
+    _currVel = nextBuffer(_currVel);
+}
+
+void FluidSolver::projectVelocity()
+{
+    const ThreadCountScope threads(_nbThreads);
+    project(_velX[_currVel], _velY[_currVel], pressureBuffer(0, _velX[nextBuffer(_currVel)]), _velY[nextBuffer(_currVel)]);
+}
+
+void FluidSolver::applyBoundaries()
+{
+    const ThreadCountScope threads(_nbThreads);
+    densityBoundaryConditions(_densities[_currDensity]);
+    velXBoundaryConditions(_velX[_currVel]);
+    velYBoundaryConditions(_velY[_currVel]);
+}
+
+void FluidSolver::solveDensity (float dt)
+{
+    PROFILE_SCOPE_CELLS("solveDensity", _nbCols*_nbLines);
+
+    /* The density and the scalars are diffused into their scratch buffers, then advected back */
+    std::vector<BufferFloat*> current, scratch;
+    getTransportedFields(current, scratch);
+    
+    diffuseFields<DensityBoundaries>(current, scratch, dt);
+    
+    /* Otherwise done by solveVelocity() */
+    if (!_fusedDensityAdvection) {
+        advectFields(scratch.data(), current.data(), current.size(), _velX[_currVel], _velY[_currVel],
+                     _nbCols, _nbLines, _pitch, dt);
+    }
+}
+
+void FluidSolver::getTransportedFields (std::vector<BufferFloat*>& current, std::vector<BufferFloat*>& scratch)
+{
+    current.assign(1, &_densities[_currDensity]);
+    scratch.assign(1, &_densities[nextBuffer(_currDensity)]);
+    for (std::array<BufferFloat, 2>& scalar : _scalars) {
+        current.push_back(&scalar[0]);
+        scratch.push_back(&scalar[1]);
+    }
+}
+
+void FluidSolver::solveVelocity (float dt)
+{
+    PROFILE_SCOPE_CELLS("solveVelocity", _nbCols*_nbLines);
+
+    diffuse<VelXBoundaries>(_velX[_currVel], _velX[nextBuffer(_currVel)], dt);
+    diffuse<VelYBoundaries>(_velY[_currVel], _velY[nextBuffer(_currVel)], dt);
+    
+    project(_velX[nextBuffer(_currVel)], _velY[nextBuffer(_currVel)], pressureBuffer(0, _velX[_currVel]), _velY[_currVel]);
+    
+    _currVel = nextBuffer(_currVel);
+    
+    /* Self-advection of both components (and of the diffused density and scalars), sharing the back-trace */
+    std::vector<BufferFloat const*> srcs = {&_velX[_currVel], &_velY[_currVel]};
+    std::vector<BufferFloat*> dsts = {&_velX[nextBuffer(_currVel)], &_velY[nextBuffer(_currVel)]};
+    if (_fusedDensityAdvection) {
+        std::vector<BufferFloat*> current, scratch;
+        getTransportedFields(current, scratch);
+        srcs.insert(srcs.end(), scratch.begin(), scratch.end());
+        dsts.insert(dsts.end(), current.begin(), current.end());
+    }
+    advectFields(srcs.data(), dsts.data(), srcs.size(), _velX[_currVel], _velY[_currVel],
+                 _nbCols, _nbLines, _pitch, dt);
+    /* The advection leaves the outer ring alone, which still holds the pressure of the first projection */
+    velXBoundaryConditions(_velX[nextBuffer(_currVel)]);
+    velYBoundaryConditions(_velY[nextBuffer(_currVel)]);
+    
+    project(_velX[nextBuffer(_currVel)], _velY[nextBuffer(_currVel)], pressureBuffer(1, _velX[_currVel]), _velY[_currVel]);
+    
+    _currVel = nextBuffer(_currVel);
+}
+
+template <class Boundaries>
+void FluidSolver::diffuse(BufferFloat const& src, BufferFloat& dst, float dt)
+{
+    PROFILE_SCOPE_CELLS("diffuse", _nbCols*_nbLines);
+
+    float a = _viscosity * _nbCols * _nbLines * dt;
+    const float hFactor = Boundaries::hFactor(), vFactor = Boundaries::vFactor();
+    
+    if (_diffusionSolver == LinearSolver::SPECTRAL && canSolveSpectrally(hFactor, vFactor)) {
+        getSpectralPoisson().solve(dst, src, 1.f + 4.f*a, a);
+        return;
+    } else if (_diffusionSolver == LinearSolver::CONJUGATE_GRADIENT) {
+        accumulate(_diffusionStats, getConjugateGradient().solve(dst, src, 1.f + 4.f*a, a, hFactor, vFactor,
+                                                                 _preconditioner, _tolerance, _maxIterations));
+        return;
+    } else if (_diffusionSolver == LinearSolver::MULTIGRID || _diffusionSolver == LinearSolver::FULL_MULTIGRID) {
+        /* Helmholtz system (1+4a)*dst - a*neighbours = src, starting from the current content of dst */
+        boundaryConditions<Boundaries>(dst);
+        getMultigrid().solve(dst, src, 1.f + 4.f*a, a, hFactor, vFactor, _multigridCycles,
+                             _diffusionSolver == LinearSolver::FULL_MULTIGRID);
+        return;
+    }
+
+    /* Gauss-Seidel relaxation for iteratively solving the linear system */
+    accumulate(_diffusionStats, getGaussSeidel().solve<Boundaries>(dst, src, 1.f + 4.f*a, a, _relaxation));
+}
+
+template <class Boundaries>
+void FluidSolver::diffuseFields(std::vector<BufferFloat*> const& srcs, std::vector<BufferFloat*> const& dsts, float dt)
+{
+    const bool relaxation = (_diffusionSolver == LinearSolver::GAUSS_SEIDEL ||
+                             (_diffusionSolver == LinearSolver::SPECTRAL &&
+                              !canSolveSpectrally(Boundaries::hFactor(), Boundaries::vFactor())));
+    if (!relaxation) {
+        for (unsigned int i = 0 ; i < srcs.size() ; ++i) {
+            diffuse<Boundaries>(*srcs[i], *dsts[i], dt);
+        }
+        return;
+    }
+
+    PROFILE_SCOPE_CELLS("diffuse", _nbCols*_nbLines);
+
+    float a = _viscosity * _nbCols * _nbLines * dt;
+    std::vector<BufferFloat const*> rhs(srcs.begin(), srcs.end());
+    accumulate(_diffusionStats, getGaussSeidel().solve<Boundaries>(dsts.data(), rhs.data(), dsts.size(),
+                                                                   1.f + 4.f*a, a, _relaxation));
+}
+
+void FluidSolver::project(BufferFloat& velX, BufferFloat& velY, BufferFloat& p, BufferFloat& div)
+{
+    PROFILE_SCOPE_CELLS("project", _nbCols*_nbLines);
+
+    switch (getFixedSize(_nbCols, _nbLines, _pitch)) {
+        case 128:
+            projectSquare<128>(velX, velY, p, div);
+            break;
+        case 256:
+            projectSquare<256>(velX, velY, p, div);
+            break;
+        case 512:
+            projectSquare<512>(velX, velY, p, div);
+            break;
+        case 1024:
+            projectSquare<1024>(velX, velY, p, div);
+            break;
+        default:
+            projectFixedSize<0, 0, 0>(velX, velY, p, div);
+            break;
+    }
+}
+
+template <unsigned int SIZE>
+void FluidSolver::projectSquare (BufferFloat& velX, BufferFloat& velY, BufferFloat& p, BufferFloat& div)
+{
+    if (_pitch == SIZE) {
+        projectFixedSize<SIZE, SIZE, SIZE>(velX, velY, p, div);
+    } else {
+        projectFixedSize<SIZE, SIZE, getPaddedPitch(SIZE)>(velX, velY, p, div);
+    }
+}
+
+template <unsigned int COLS, unsigned int LINES, unsigned int PITCH>
+void FluidSolver::projectFixedSize (BufferFloat& velX, BufferFloat& velY, BufferFloat& p, BufferFloat& div)
+{
+    const unsigned int nbCols = dimension<COLS>(_nbCols);
+    const unsigned int nbLines = dimension<LINES>(_nbLines);
+    const unsigned int pitch = dimension<PITCH>(_pitch);
+    float h = 1.f / std::sqrt(nbLines*nbCols);
+    
+    /* The outer rings are set line by line, while the lines are in cache */
+    for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+            const unsigned int i = line*pitch + col;
+            div[i] = -0.5f * h * (velX[i+1] - velX[i-1] + velY[i+pitch] - velY[i-pitch]);
+        }
+        PressureBoundaries::applyLine(div, nbCols, nbLines, pitch, line);
+    }
+    if (!_warmStart) {
+        std::fill(p.begin(), p.end(), 0.f);
+    }
+    
+    if (_pressureSolver == LinearSolver::SPECTRAL && canSolveSpectrally(1.f, 1.f)) {
+        getSpectralPoisson().solve(p, div, 4.f, 1.f);
+    } else if (_pressureSolver == LinearSolver::CONJUGATE_GRADIENT) {
+        accumulate(_pressureStats, getConjugateGradient().solve(p, div, 4.f, 1.f, 1.f, 1.f,
+                                                                _preconditioner, _tolerance, _maxIterations));
+    } else if (_pressureSolver == LinearSolver::MULTIGRID || _pressureSolver == LinearSolver::FULL_MULTIGRID) {
+        getMultigrid().solve(p, div, 4.f, 1.f, 1.f, 1.f, _multigridCycles,
+                             _pressureSolver == LinearSolver::FULL_MULTIGRID);
+    } else {
+        /* Gauss Seidel relaxation */
+        accumulate(_pressureStats, getGaussSeidel().solve<PressureBoundaries>(p, div, 4.f, 1.f, _relaxation));
+    }
+    
+    for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+            const unsigned int i = line*pitch + col;
+            velX[i] -= 0.5f * (p[i+1] - p[i-1]) / h;
+            velY[i] -= 0.5f * (p[i+pitch] - p[i-pitch]) / h;
+        }
+        VelXBoundaries::applyLine(velX, nbCols, nbLines, pitch, line);
+        VelYBoundaries::applyLine(velY, nbCols, nbLines, pitch, line);
+    }
+}
+
+BufferFloat& FluidSolver::pressureBuffer (unsigned int iProjection, BufferFloat& scratch)
+{
+    if (!_warmStart)
+        return scratch;
+
+    BufferFloat& pressure = _pressures[iProjection];
+    if (pressure.empty()) {
+        allocateField(pressure);
+    }
+    return pressure;
+}
+
+void FluidSolver::accumulate (SolveStats& total, SolveStats const& stats) const
+{
+    total.iterations += stats.iterations;
+    total.residual = std::max(total.residual, stats.residual);
+}
+
+GaussSeidel& FluidSolver::getGaussSeidel()
+{
+    if (!_gaussSeidel) {
+        _gaussSeidel.reset(new GaussSeidel(_nbCols, _nbLines, _pitch));
+    }
+    return *_gaussSeidel;
+}
+
+Multigrid& FluidSolver::getMultigrid()
+{
+    if (!_multigrid) {
+        _multigrid.reset(new Multigrid(_nbCols, _nbLines, _pitch));
+    }
+    return *_multigrid;
+}
+
+ConjugateGradient& FluidSolver::getConjugateGradient()
+{
+    if (!_conjugateGradient) {
+        _conjugateGradient.reset(new ConjugateGradient(_nbCols, _nbLines, _pitch));
+    }
+    return *_conjugateGradient;
+}
+
+SpectralPoisson& FluidSolver::getSpectralPoisson()
+{
+    if (!_spectralPoisson) {
+        _spectralPoisson.reset(new SpectralPoisson(_nbCols, _nbLines, _pitch));
+    }
+    return *_spectralPoisson;
+}
+
+bool FluidSolver::canSolveSpectrally (float hFactor, float vFactor) const
+{
+    return hFactor == 1.f && vFactor == 1.f && SpectralPoisson::isSupported(_nbCols, _nbLines);
+}
+
+template <class Boundaries>
+void FluidSolver::boundaryConditions (BufferFloat& buffer)
+{
+    PROFILE_SCOPE("boundaryConditions");
+
+    Boundaries::apply(buffer, _nbCols, _nbLines, _pitch);
+}
+
+void FluidSolver::densityBoundaryConditions(BufferFloat& densities)
+{
+    boundaryConditions<DensityBoundaries>(densities);
+}
+
+void FluidSolver::velXBoundaryConditions(BufferFloat& velX)
+{
+    boundaryConditions<VelXBoundaries>(velX);
+}
+
+void FluidSolver::velYBoundaryConditions(BufferFloat& velY)
+{
+    boundaryConditions<VelYBoundaries>(velY);
+}
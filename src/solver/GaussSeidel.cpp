@@ -0,0 +1,516 @@
+#include "GaussSeidel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Boundaries.hpp"
+#include "Simd.hpp"
+#include "Tracer.hpp"
+
+
+/* Bytes of cache the lines relaxed by a pass of temporal blocking should fit in (about L2) */
+static const unsigned int BLOCKING_CACHE_SIZE = 1 << 20;
+
+/* Relaxes the cells firstCol, firstCol+step... of the interior of a line.
+ * x and rhs point to the first cell of the line. When MEASURE is set, returns the squared
+ * 2-norm of the residuals met by the cells right before their update, 0 otherwise. */
+template <bool MEASURE, unsigned int COLS, unsigned int PITCH>
+static double relaxLine (float* x, float const* rhs, unsigned int runtimeCols, unsigned int runtimePitch,
+                         unsigned int firstCol, unsigned int step, float diag, float coupling)
+{
+    const unsigned int nbCols = dimension<COLS>(runtimeCols);
+    const unsigned int pitch = dimension<PITCH>(runtimePitch);
+    const float invDiag = 1.f / diag;
+    float const* above = x - pitch;
+    float const* below = x + pitch;
+    double residual = 0.0;
+
+    for (unsigned int col = firstCol ; col < nbCols-1 ; col += step) {
+        float neighbours = above[col] + below[col] + x[col-1] + x[col+1];
+        float updated = (rhs[col] + coupling * neighbours) * invDiag;
+
+        if (MEASURE) {
+            double r = diag * (updated - x[col]);
+            residual += r * r;
+        }
+        x[col] = updated;
+    }
+
+    return residual;
+}
+
+/* Fields relaxed together by relaxLines */
+static const unsigned int MAX_INTERLEAVED_FIELDS = 4;
+
+/* Cells of a line relaxLines goes through at a time */
+#ifdef SIMD_ENABLED
+static const unsigned int LEXICOGRAPHIC_CHUNK = simd::WIDTH;
+#else
+static const unsigned int LEXICOGRAPHIC_CHUNK = 16;
+#endif
+
+/* The part of the updates of nbCells consecutive cells that does not depend on their left
+ * neighbour: the line above is relaxed already, the line below and the cells on the right not yet. */
+inline void computeOldNeighbours (float const* x, float const* rhs, unsigned int pitch, unsigned int nbCells,
+                                  float coupling, float invDiag, float* partial)
+{
+    float const* above = x - pitch;
+    float const* below = x + pitch;
+
+#ifdef SIMD_ENABLED
+    if (nbCells == simd::WIDTH) {
+        simd::Floats neighbours = simd::add(simd::add(simd::load(above), simd::load(below)), simd::load(x + 1));
+        simd::Floats updated = simd::fmadd(simd::set(coupling), neighbours, simd::load(rhs));
+        simd::store(partial, simd::mul(updated, simd::set(invDiag)));
+        return;
+    }
+#endif
+    for (unsigned int i = 0 ; i < nbCells ; ++i) {
+        partial[i] = (rhs[i] + coupling * ((above[i] + below[i]) + x[i + 1])) * invDiag;
+    }
+}
+
+/* Relaxes the whole interior of the same line of NB_FIELDS fields, LEXICOGRAPHIC_CHUNK cells at a
+ * time. Everything but the left neighbour is gathered for the whole chunk first (in vectors), so
+ * the recurrence left from cell to cell is a single multiply-add. The fields overlap in it instead
+ * of each one being bound by its latency. Same results as relaxing the fields one by one. */
+template <bool MEASURE, unsigned int COLS, unsigned int PITCH, unsigned int NB_FIELDS>
+static double relaxLines (float* const* x, float const* const* rhs, unsigned int runtimeCols, unsigned int runtimePitch,
+                          float diag, float coupling)
+{
+    const unsigned int nbCols = dimension<COLS>(runtimeCols);
+    const unsigned int pitch = dimension<PITCH>(runtimePitch);
+    const float invDiag = 1.f / diag;
+    const float leftWeight = coupling * invDiag;
+    float partial[NB_FIELDS][LEXICOGRAPHIC_CHUNK];
+    double residual = 0.0;
+
+    for (unsigned int first = 1 ; first < nbCols-1 ; first += LEXICOGRAPHIC_CHUNK) {
+        const unsigned int nbCells = std::min(LEXICOGRAPHIC_CHUNK, nbCols-1 - first);
+        for (unsigned int iField = 0 ; iField < NB_FIELDS ; ++iField) {
+            computeOldNeighbours(x[iField] + first, rhs[iField] + first, pitch, nbCells, coupling, invDiag, partial[iField]);
+        }
+
+        for (unsigned int i = 0 ; i < nbCells ; ++i) {
+            for (unsigned int iField = 0 ; iField < NB_FIELDS ; ++iField) {
+                float* cell = x[iField] + first + i;
+                float updated = partial[iField][i] + leftWeight * cell[-1];
+
+                if (MEASURE) {
+                    double r = diag * (updated - *cell);
+                    residual += r * r;
+                }
+                *cell = updated;
+            }
+        }
+    }
+
+    return residual;
+}
+
+/* Relaxes the same line of all the fields, MAX_INTERLEAVED_FIELDS at a time */
+template <bool MEASURE, unsigned int COLS, unsigned int PITCH>
+static double relaxFieldsLine (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                               unsigned int runtimeCols, unsigned int runtimePitch, unsigned int line,
+                               float diag, float coupling)
+{
+    const unsigned int nbCols = dimension<COLS>(runtimeCols);
+    const unsigned int pitch = dimension<PITCH>(runtimePitch);
+    double residual = 0.0;
+
+    for (unsigned int first = 0 ; first < nbFields ; first += MAX_INTERLEAVED_FIELDS) {
+        const unsigned int nbInterleaved = std::min(MAX_INTERLEAVED_FIELDS, nbFields - first);
+        float* xLines[MAX_INTERLEAVED_FIELDS];
+        float const* rhsLines[MAX_INTERLEAVED_FIELDS];
+        for (unsigned int i = 0 ; i < nbInterleaved ; ++i) {
+            xLines[i] = x[first+i]->data() + line*pitch;
+            rhsLines[i] = rhs[first+i]->data() + line*pitch;
+        }
+
+        switch (nbInterleaved) {
+            case 1:
+                residual += relaxLines<MEASURE, COLS, PITCH, 1>(xLines, rhsLines, nbCols, pitch, diag, coupling);
+                break;
+            case 2:
+                residual += relaxLines<MEASURE, COLS, PITCH, 2>(xLines, rhsLines, nbCols, pitch, diag, coupling);
+                break;
+            case 3:
+                residual += relaxLines<MEASURE, COLS, PITCH, 3>(xLines, rhsLines, nbCols, pitch, diag, coupling);
+                break;
+            default:
+                residual += relaxLines<MEASURE, COLS, PITCH, 4>(xLines, rhsLines, nbCols, pitch, diag, coupling);
+                break;
+        }
+    }
+
+    return residual;
+}
+
+#ifdef SIMD_ENABLED
+
+/* The vectors of relaxLineColour, from the start of the line (the ring cell of the first vector is
+ * left out) as long as they fit in the interior. With ALIGNED, the line starts on a whole vector
+ * and so do the lines above and below: all the loads but the left and right neighbours are aligned.
+ * Returns the squared 2-norm of the residuals, col being left on the first cell not done. */
+template <bool MEASURE, bool ALIGNED, unsigned int COLS, unsigned int PITCH>
+static double relaxVectorsColour (float* xLine, float const* rhsLine, unsigned int runtimeCols, unsigned int runtimePitch,
+                                  unsigned int line, unsigned int colour, float diag, float coupling, unsigned int& col)
+{
+    const unsigned int nbCols = dimension<COLS>(runtimeCols);
+    const unsigned int pitch = dimension<PITCH>(runtimePitch);
+
+    /* Whole vectors are updated from the other colour, and only the lanes of this colour are stored
+     * and added to the residual. The lines above and below, which other threads are relaxing, are only
+     * read on the cells of the other colour, and no cell of the other colour is written: the threads
+     * never touch the same cell at the same time, not even to write back an unchanged value.
+     * The next vector is loaded before the current one is stored: its left neighbours overlap this
+     * store, which would defeat store-to-load forwarding, and they are of the other colour anyway. */
+    const simd::Mask colourLanes = simd::alternate((line + colour) % 2); //col is even at the start of each vector
+    const simd::Floats vDiag = simd::set(diag);
+    const simd::Floats vInvDiag = simd::set(1.f / diag);
+    const simd::Floats vCoupling = simd::set(coupling);
+    simd::Floats vResidual = simd::set(0.f);
+
+    struct Stencil
+    {
+        simd::Mask lanes;
+        simd::Floats center, neighbours, rhs;
+    };
+    auto loadStencil = [&] (unsigned int c, simd::Mask lanes) {
+        float const* cell = xLine + c;
+        Stencil s;
+        s.lanes = lanes;
+        s.center = ALIGNED ? simd::loadAligned(cell) : simd::load(cell);
+        s.neighbours = simd::add(simd::add(simd::add(simd::maskLoad(lanes, cell - pitch),
+                                                     simd::maskLoad(lanes, cell + pitch)),
+                                           simd::maskLoad(lanes, cell - 1)),
+                                 simd::load(cell + 1));
+        s.rhs = ALIGNED ? simd::loadAligned(rhsLine + c) : simd::load(rhsLine + c);
+        return s;
+    };
+
+    col = 0;
+    if (col + simd::WIDTH <= nbCols-1) {
+        Stencil next = loadStencil(col, simd::withoutFirstLane(colourLanes));
+        for ( ; col + simd::WIDTH <= nbCols-1 ; col += simd::WIDTH) {
+            const Stencil current = next;
+            if (col + 2*simd::WIDTH <= nbCols-1) {
+                next = loadStencil(col + simd::WIDTH, colourLanes);
+            }
+
+            const simd::Floats updated = simd::mul(simd::fmadd(vCoupling, current.neighbours, current.rhs), vInvDiag);
+
+            if (MEASURE) {
+                const simd::Floats change = simd::sub(simd::select(current.lanes, current.center, updated), current.center);
+                const simd::Floats r = simd::mul(vDiag, change);
+                vResidual = simd::fmadd(r, r, vResidual);
+            }
+            simd::maskStore(xLine + col, current.lanes, updated);
+        }
+    }
+    col = std::max(1u, col);
+    return simd::sum(vResidual);
+}
+
+#endif
+
+/* Relaxes the cells of a line which have the given colour, (line + col) % 2 */
+template <bool MEASURE, unsigned int COLS, unsigned int PITCH>
+static double relaxLineColour (BufferFloat& x, BufferFloat const& rhs,
+                               unsigned int runtimeCols, unsigned int runtimePitch, unsigned int line, unsigned int colour, float diag, float coupling)
+{
+    const unsigned int nbCols = dimension<COLS>(runtimeCols);
+    const unsigned int pitch = dimension<PITCH>(runtimePitch);
+    float* xLine = x.data() + line*pitch;
+    float const* rhsLine = rhs.data() + line*pitch;
+    unsigned int col = 1;
+    double residual = 0.0;
+
+#ifdef SIMD_ENABLED
+    /* Padded lines (or dense ones a multiple of the vector width long) start on whole vectors */
+    if (pitch % simd::WIDTH == 0 && simd::isAligned(xLine) && simd::isAligned(rhsLine)) {
+        residual = relaxVectorsColour<MEASURE, true, COLS, PITCH>(xLine, rhsLine, nbCols, pitch, line, colour,
+                                                                  diag, coupling, col);
+    } else {
+        residual = relaxVectorsColour<MEASURE, false, COLS, PITCH>(xLine, rhsLine, nbCols, pitch, line, colour,
+                                                                   diag, coupling, col);
+    }
+#endif
+
+    /* Remaining cells, starting from the first one of the colour */
+    const unsigned int firstCol = col + (line + col + colour) % 2;
+    return residual + relaxLine<MEASURE, COLS, PITCH>(xLine, rhsLine, nbCols, pitch, firstCol, 2, diag, coupling);
+}
+
+GaussSeidel::GaussSeidel (unsigned int nbCols, unsigned int nbLines, unsigned int pitch):
+            _nbCols(nbCols),
+            _nbLines(nbLines),
+            _pitch(pitch)
+{
+}
+
+template <class Boundaries>
+SolveStats GaussSeidel::solve (BufferFloat& x, BufferFloat const& rhs, float diag, float coupling,
+                               RelaxationSettings const& settings)
+{
+    BufferFloat* xs[] = {&x};
+    BufferFloat const* rhss[] = {&rhs};
+    return solve<Boundaries>(xs, rhss, 1, diag, coupling, settings);
+}
+
+template <class Boundaries>
+SolveStats GaussSeidel::solve (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                               float diag, float coupling, RelaxationSettings const& settings)
+{
+    SolveStats stats;
+    stats.iterations = 0;
+    stats.residual = 0.f;
+
+    switch (getFixedSize(_nbCols, _nbLines, _pitch)) {
+        case 128:
+            solveSquare<Boundaries, 128>(x, rhs, nbFields, diag, coupling, settings, stats);
+            break;
+        case 256:
+            solveSquare<Boundaries, 256>(x, rhs, nbFields, diag, coupling, settings, stats);
+            break;
+        case 512:
+            solveSquare<Boundaries, 512>(x, rhs, nbFields, diag, coupling, settings, stats);
+            break;
+        case 1024:
+            solveSquare<Boundaries, 1024>(x, rhs, nbFields, diag, coupling, settings, stats);
+            break;
+        default:
+            solveFixedSize<Boundaries, 0, 0, 0>(x, rhs, nbFields, diag, coupling, settings, stats);
+            break;
+    }
+
+    return stats;
+}
+
+template <class Boundaries, unsigned int SIZE>
+void GaussSeidel::solveSquare (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                               float diag, float coupling, RelaxationSettings const& settings, SolveStats& stats)
+{
+    if (_pitch == SIZE) {
+        solveFixedSize<Boundaries, SIZE, SIZE, SIZE>(x, rhs, nbFields, diag, coupling, settings, stats);
+    } else {
+        solveFixedSize<Boundaries, SIZE, SIZE, getPaddedPitch(SIZE)>(x, rhs, nbFields, diag, coupling, settings, stats);
+    }
+}
+
+template <class Boundaries, unsigned int COLS, unsigned int LINES, unsigned int PITCH>
+void GaussSeidel::solveFixedSize (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                                  float diag, float coupling, RelaxationSettings const& settings, SolveStats& stats)
+{
+    if (settings.ordering == SweepOrdering::RED_BLACK) {
+        solveRedBlack<Boundaries, COLS, LINES, PITCH>(x, rhs, nbFields, diag, coupling, settings, stats);
+    } else {
+        solveLexicographic<Boundaries, COLS, LINES, PITCH>(x, rhs, nbFields, diag, coupling, settings, stats);
+    }
+}
+
+bool GaussSeidel::isChecked (unsigned int sweep, RelaxationSettings const& settings) const
+{
+    const unsigned int checkInterval = std::max(1u, settings.checkInterval);
+    return (settings.tolerance > 0.f && sweep % checkInterval == 0) || sweep == settings.maxSweeps;
+}
+
+unsigned int GaussSeidel::getMaxSweepsPerPass (unsigned int sweepsPerPass, unsigned int nbFields) const
+{
+    const unsigned int lineSize = 2 * nbFields * _pitch * sizeof(float); //x and rhs of every field
+    const unsigned int cachedLines = std::max(3u, BLOCKING_CACHE_SIZE / lineSize);
+    return std::max(1u, std::min(sweepsPerPass, cachedLines - 2));
+}
+
+template <class Boundaries, unsigned int COLS, unsigned int LINES, unsigned int PITCH>
+void GaussSeidel::solveLexicographic (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                                      float diag, float coupling, RelaxationSettings const& settings,
+                                      SolveStats& stats) const
+{
+    const double rhsNorm = std::sqrt(norm2(rhs, nbFields));
+    const double target = settings.tolerance * rhsNorm;
+    const unsigned int maxSweepsPerPass = getMaxSweepsPerPass(settings.sweepsPerPass, nbFields);
+
+    while (stats.iterations < settings.maxSweeps) {
+        /* A pass ends on the next sweep measuring the residual */
+        unsigned int nbSweeps = 1;
+        while (nbSweeps < maxSweepsPerPass && !isChecked(stats.iterations + nbSweeps, settings)) {
+            ++nbSweeps;
+        }
+        stats.iterations += nbSweeps;
+
+        const bool measure = isChecked(stats.iterations, settings);
+        const double residual = measure ?
+                                relaxPass<Boundaries, true, COLS, LINES, PITCH>(x, rhs, nbFields, diag, coupling, nbSweeps) :
+                                relaxPass<Boundaries, false, COLS, LINES, PITCH>(x, rhs, nbFields, diag, coupling, nbSweeps);
+
+        if (measure) {
+            const double residualNorm = std::sqrt(residual);
+            stats.residual = (rhsNorm > 0.0) ? residualNorm / rhsNorm : 0.f;
+            if (residualNorm <= target)
+                break;
+        }
+    }
+}
+
+template <class Boundaries, bool MEASURE, unsigned int COLS, unsigned int LINES, unsigned int PITCH>
+double GaussSeidel::relaxPass (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                               float diag, float coupling, unsigned int nbSweeps) const
+{
+    /* At step s, sweep k relaxes line s-k. The sweeps go from the most advanced one to the least
+     * advanced one, so when sweep k reaches a line, sweep k-1 already relaxed the line below and
+     * is not back on the line above yet: exactly what a sweep sees when done over the whole grid.
+     * The outer ring is updated line by line, as soon as a line is relaxed. */
+    const unsigned int nbCols = dimension<COLS>(_nbCols);
+    const unsigned int nbLines = dimension<LINES>(_nbLines);
+    const unsigned int pitch = dimension<PITCH>(_pitch);
+    const unsigned int nbInteriorLines = nbLines-2;
+    double residual = 0.0;
+
+    for (unsigned int step = 0 ; step < nbInteriorLines + nbSweeps-1 ; ++step) {
+        for (unsigned int k = 0 ; k < nbSweeps && k <= step ; ++k) {
+            const unsigned int line = 1 + step - k;
+            if (line > nbInteriorLines)
+                continue;
+
+            if (MEASURE && k == nbSweeps-1) {
+                residual += relaxFieldsLine<true, COLS, PITCH>(x, rhs, nbFields, nbCols, pitch, line, diag, coupling);
+            } else {
+                relaxFieldsLine<false, COLS, PITCH>(x, rhs, nbFields, nbCols, pitch, line, diag, coupling);
+            }
+            for (unsigned int iField = 0 ; iField < nbFields ; ++iField) {
+                Boundaries::applyLine(*x[iField], nbCols, nbLines, pitch, line);
+            }
+        }
+    }
+
+    return residual;
+}
+
+template <class Boundaries, unsigned int COLS, unsigned int LINES, unsigned int PITCH>
+void GaussSeidel::solveRedBlack (BufferFloat* const* x, BufferFloat const* const* rhs, unsigned int nbFields,
+                                 float diag, float coupling, RelaxationSettings const& settings, SolveStats& stats)
+{
+    const unsigned int nbCols = dimension<COLS>(_nbCols);
+    const unsigned int nbLines = dimension<LINES>(_nbLines);
+    const unsigned int pitch = dimension<PITCH>(_pitch);
+    const double rhsNorm = std::sqrt(norm2(rhs, nbFields));
+    const double target = settings.tolerance * rhsNorm;
+
+#ifdef _OPENMP
+    _partialResiduals.resize(omp_get_max_threads());
+#else
+    _partialResiduals.resize(1);
+#endif
+
+    #pragma omp parallel
+    {
+        TRACE_SCOPE("redBlackSweeps");
+#ifdef _OPENMP
+        const unsigned int thread = omp_get_thread_num();
+        const unsigned int nbThreads = omp_get_num_threads();
+#else
+        const unsigned int thread = 0;
+        const unsigned int nbThreads = 1;
+#endif
+        unsigned int sweep = 0;
+        float relativeResidual = 0.f;
+
+        while (sweep < settings.maxSweeps) {
+            ++sweep;
+
+            const bool measure = isChecked(sweep, settings);
+            double residual = 0.0;
+
+            #pragma omp for schedule(static)
+            for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+                for (unsigned int iField = 0 ; iField < nbFields ; ++iField) {
+                    if (measure) {
+                        residual += relaxLineColour<true, COLS, PITCH>(*x[iField], *rhs[iField], nbCols, pitch, line, 0,
+                                                                       diag, coupling);
+                    } else {
+                        relaxLineColour<false, COLS, PITCH>(*x[iField], *rhs[iField], nbCols, pitch, line, 0,
+                                                            diag, coupling);
+                    }
+                }
+            }
+
+            #pragma omp for schedule(static) nowait
+            for (unsigned int line = 1 ; line < nbLines-1 ; ++line) {
+                for (unsigned int iField = 0 ; iField < nbFields ; ++iField) {
+                    if (measure) {
+                        residual += relaxLineColour<true, COLS, PITCH>(*x[iField], *rhs[iField], nbCols, pitch, line, 1,
+                                                                       diag, coupling);
+                    } else {
+                        relaxLineColour<false, COLS, PITCH>(*x[iField], *rhs[iField], nbCols, pitch, line, 1,
+                                                            diag, coupling);
+                    }
+                    Boundaries::applyLine(*x[iField], nbCols, nbLines, pitch, line);
+                }
+            }
+
+            if (measure) {
+                _partialResiduals[thread] = residual;
+            }
+            #pragma omp barrier
+
+            if (measure) {
+                /* Every thread sums in the same order, so they all take the same decision.
+                 * The partial residuals are not written again before the next barrier. */
+                double total = 0.0;
+                for (unsigned int i = 0 ; i < nbThreads ; ++i) {
+                    total += _partialResiduals[i];
+                }
+
+                const double residualNorm = std::sqrt(total);
+                relativeResidual = (rhsNorm > 0.0) ? residualNorm / rhsNorm : 0.f;
+                if (residualNorm <= target)
+                    break;
+            }
+        }
+
+        #pragma omp master
+        {
+            stats.iterations = sweep;
+            stats.residual = relativeResidual;
+        }
+    }
+}
+
+double GaussSeidel::norm2 (BufferFloat const* const* buffers, unsigned int nbFields) const
+{
+    double sum = 0.0;
+    #pragma omp parallel for schedule(static) reduction(+:sum)
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        for (unsigned int iField = 0 ; iField < nbFields ; ++iField) {
+            BufferFloat const& buffer = *buffers[iField];
+            for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+                double value = buffer[line*_pitch + col];
+                sum += value * value;
+            }
+        }
+    }
+    return sum;
+}
+
+template SolveStats GaussSeidel::solve<DensityBoundaries> (BufferFloat&, BufferFloat const&, float, float,
+                                                           RelaxationSettings const&);
+template SolveStats GaussSeidel::solve<VelXBoundaries> (BufferFloat&, BufferFloat const&, float, float,
+                                                        RelaxationSettings const&);
+template SolveStats GaussSeidel::solve<VelYBoundaries> (BufferFloat&, BufferFloat const&, float, float,
+                                                        RelaxationSettings const&);
+template SolveStats GaussSeidel::solve<PressureBoundaries> (BufferFloat&, BufferFloat const&, float, float,
+                                                            RelaxationSettings const&);
+
+template SolveStats GaussSeidel::solve<DensityBoundaries> (BufferFloat* const*, BufferFloat const* const*, unsigned int,
+                                                           float, float, RelaxationSettings const&);
+template SolveStats GaussSeidel::solve<VelXBoundaries> (BufferFloat* const*, BufferFloat const* const*, unsigned int,
+                                                        float, float, RelaxationSettings const&);
+template SolveStats GaussSeidel::solve<VelYBoundaries> (BufferFloat* const*, BufferFloat const* const*, unsigned int,
+                                                        float, float, RelaxationSettings const&);
+template SolveStats GaussSeidel::solve<PressureBoundaries> (BufferFloat* const*, BufferFloat const* const*, unsigned int,
+                                                            float, float, RelaxationSettings const&);
@@ -0,0 +1,372 @@
+#include "Multigrid.hpp"
+
+#include <algorithm>
+
+#include "Boundaries.hpp"
+
+
+/* Coarsening stops when the interior of a level gets smaller than this in one direction */
+static const unsigned int COARSEST_SIZE = 4;
+
+/* Area of each cell of a coarse dimension, from the areas of the finer one */
+static std::vector<float> coarsenAreas (std::vector<float> const& fineAreas, unsigned int coarseSize)
+{
+    std::vector<float> areas(coarseSize, 0.f);
+    for (unsigned int i = 1 ; i < coarseSize-1 ; ++i) {
+        areas[i] = fineAreas[2*i-1] + fineAreas[2*i]; //the outer ring has no area
+    }
+    return areas;
+}
+
+Multigrid::Multigrid (unsigned int nbCols, unsigned int nbLines, unsigned int pitch):
+            _currentOperators(nullptr),
+            _identity(0.f),
+            _coupling(0.f),
+            _hFactor(1.f),
+            _vFactor(1.f),
+            _singular(false),
+            _nbPreSmooth(2),
+            _nbPostSmooth(2),
+            _nbCoarsestSweeps(50)
+{
+    unsigned int interiorCols = nbCols-2, interiorLines = nbLines-2;
+    for (;;) {
+        Level level;
+        level.nbCols = interiorCols + 2;
+        level.nbLines = interiorLines + 2;
+        level.pitch = _levels.empty() ? pitch : level.nbCols;
+        if (_levels.empty()) {
+            level.colAreas.assign(level.nbCols, 1.f);
+            level.lineAreas.assign(level.nbLines, 1.f);
+            level.colAreas.front() = level.colAreas.back() = 0.f;
+            level.lineAreas.front() = level.lineAreas.back() = 0.f;
+        } else {
+            level.colAreas = coarsenAreas(_levels.back().colAreas, level.nbCols);
+            level.lineAreas = coarsenAreas(_levels.back().lineAreas, level.nbLines);
+            level.x.resize(level.pitch*level.nbLines, 0.f);
+            level.rhs.resize(level.pitch*level.nbLines, 0.f);
+            for (BufferFloat& coefficients : level.stencil) {
+                coefficients.resize(level.pitch*level.nbLines, 0.f);
+            }
+        }
+        level.residual.resize(level.pitch*level.nbLines, 0.f);
+        _levels.push_back(level);
+
+        if (interiorCols <= COARSEST_SIZE || interiorLines <= COARSEST_SIZE)
+            break;
+
+        interiorCols = (interiorCols + 1) / 2;
+        interiorLines = (interiorLines + 1) / 2;
+    }
+}
+
+unsigned int Multigrid::getNbLevels() const
+{
+    return _levels.size();
+}
+
+void Multigrid::solve (BufferFloat& x, BufferFloat const& rhs, float diag, float coupling,
+                       float hFactor, float vFactor, unsigned int nbCycles, bool fullMultigrid)
+{
+    _identity = diag - 4.f * coupling;
+    _coupling = coupling;
+    _hFactor = hFactor;
+    _vFactor = vFactor;
+    _singular = (_identity == 0.f && hFactor == 1.f && vFactor == 1.f);
+
+    /* Coarse operators of this system */
+    _currentOperators = &getOperators();
+    for (unsigned int i = 1 ; i < _levels.size() ; ++i) {
+        Stencil const& identity = _currentOperators->identity[i-1];
+        Stencil const& laplacian = _currentOperators->laplacian[i-1];
+        Stencil& stencil = _levels[i].stencil;
+        for (unsigned int d = 0 ; d < 9 ; ++d) {
+            for (std::size_t cell = 0 ; cell < stencil[d].size() ; ++cell) {
+                stencil[d][cell] = _identity * identity[d][cell] + _coupling * laplacian[d][cell];
+            }
+        }
+    }
+
+    if (fullMultigrid && _levels.size() > 1) {
+        /* Solves on the coarsest level first, then uses each solution as first guess for the finer level */
+        for (unsigned int i = 1 ; i < _levels.size() ; ++i) {
+            BufferFloat const& fineRhs = (i == 1) ? rhs : _levels[i-1].rhs;
+            restrict(_levels[i-1], fineRhs, _levels[i], _levels[i].rhs);
+            makeCompatible(_levels[i], _levels[i].rhs);
+        }
+
+        Level& coarsest = _levels.back();
+        std::fill(coarsest.x.begin(), coarsest.x.end(), 0.f);
+        smooth(_levels.size()-1, coarsest.x, coarsest.rhs, _nbCoarsestSweeps);
+
+        for (unsigned int i = _levels.size()-1 ; i > 0 ; --i) {
+            BufferFloat& fineX = (i == 1) ? x : _levels[i-1].x;
+            BufferFloat const& fineRhs = (i == 1) ? rhs : _levels[i-1].rhs;
+
+            prolongate(_levels[i], _levels[i].x, _levels[i-1], fineX, false);
+            if (i == 1) {
+                Level const& finest = _levels[0];
+                applyBoundaryConditions(fineX, finest.nbCols, finest.nbLines, finest.pitch, _hFactor, _vFactor);
+            }
+            vCycle(i-1, fineX, fineRhs);
+        }
+    }
+
+    for (unsigned int k = 0 ; k < nbCycles ; ++k) {
+        vCycle(0, x, rhs);
+    }
+}
+
+Multigrid::Operators const& Multigrid::getOperators()
+{
+    for (Operators const& operators : _operators) {
+        if (operators.hFactor == _hFactor && operators.vFactor == _vFactor)
+            return operators;
+    }
+
+    Operators operators;
+    operators.hFactor = _hFactor;
+    operators.vFactor = _vFactor;
+    operators.identity.resize(_levels.size()-1);
+    operators.laplacian.resize(_levels.size()-1);
+    for (unsigned int i = 1 ; i < _levels.size() ; ++i) {
+        Stencil const* fineIdentity = (i == 1) ? nullptr : &operators.identity[i-2];
+        Stencil const* fineLaplacian = (i == 1) ? nullptr : &operators.laplacian[i-2];
+        buildCoarseStencil(i, fineIdentity, true, operators.identity[i-1]);
+        buildCoarseStencil(i, fineLaplacian, false, operators.laplacian[i-1]);
+    }
+
+    _operators.push_back(operators);
+    return _operators.back();
+}
+
+void Multigrid::buildCoarseStencil (unsigned int iLevel, Stencil const* fineStencil, bool identity, Stencil& coarseStencil)
+{
+    Level const& fine = _levels[iLevel-1];
+    Level const& coarse = _levels[iLevel];
+
+    BufferFloat probe(coarse.pitch*coarse.nbLines);
+    BufferFloat fineProbe(fine.pitch*fine.nbLines, 0.f);
+    BufferFloat fineResult(fine.pitch*fine.nbLines, 0.f);
+    BufferFloat result(coarse.pitch*coarse.nbLines, 0.f);
+    for (BufferFloat& coefficients : coarseStencil) {
+        coefficients.assign(coarse.pitch*coarse.nbLines, 0.f);
+    }
+
+    for (unsigned int probeLine = 0 ; probeLine < 3 ; ++probeLine) {
+        for (unsigned int probeCol = 0 ; probeCol < 3 ; ++probeCol) {
+            std::fill(probe.begin(), probe.end(), 0.f);
+            for (unsigned int line = 1 ; line < coarse.nbLines-1 ; ++line) {
+                for (unsigned int col = 1 ; col < coarse.nbCols-1 ; ++col) {
+                    if (line % 3 == probeLine && col % 3 == probeCol) {
+                        probe[line*coarse.pitch + col] = 1.f;
+                    }
+                }
+            }
+
+            prolongate(coarse, probe, fine, fineProbe, false);
+            if (iLevel == 1) {
+                applyBoundaryConditions(fineProbe, fine.nbCols, fine.nbLines, fine.pitch, _hFactor, _vFactor);
+            }
+            applyOperator(iLevel-1, fineStencil, identity, fineProbe, fineResult);
+            restrict(fine, fineResult, coarse, result);
+
+            /* Each coarse cell only sees one probed cell in its neighbourhood */
+            for (unsigned int line = 1 ; line < coarse.nbLines-1 ; ++line) {
+                int dLine = (probeLine + 3 - line % 3) % 3;
+                dLine = (dLine == 2) ? -1 : dLine;
+                for (unsigned int col = 1 ; col < coarse.nbCols-1 ; ++col) {
+                    int dCol = (probeCol + 3 - col % 3) % 3;
+                    dCol = (dCol == 2) ? -1 : dCol;
+
+                    unsigned int i = line*coarse.pitch + col;
+                    coarseStencil[(dLine+1)*3 + (dCol+1)][i] = result[i];
+                }
+            }
+        }
+    }
+}
+
+void Multigrid::applyOperator (unsigned int iLevel, Stencil const* stencil, bool identity,
+                               BufferFloat const& x, BufferFloat& y) const
+{
+    Level const& level = _levels[iLevel];
+    const unsigned int nbCols = level.nbCols;
+    const unsigned int pitch = level.pitch;
+
+    for (unsigned int line = 1 ; line < level.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+            unsigned int i = line*pitch + col;
+            if (stencil) {
+                Stencil const& a = *stencil;
+                y[i] = a[0][i] * x[i-pitch-1] + a[1][i] * x[i-pitch] + a[2][i] * x[i-pitch+1] +
+                       a[3][i] * x[i-1]        + a[4][i] * x[i]        + a[5][i] * x[i+1] +
+                       a[6][i] * x[i+pitch-1] + a[7][i] * x[i+pitch] + a[8][i] * x[i+pitch+1];
+            } else if (identity) {
+                y[i] = x[i];
+            } else {
+                y[i] = 4.f * x[i] - (x[i-pitch] + x[i+pitch] + x[i-1] + x[i+1]);
+            }
+        }
+    }
+}
+
+void Multigrid::vCycle (unsigned int iLevel, BufferFloat& x, BufferFloat const& rhs)
+{
+    Level& level = _levels[iLevel];
+
+    if (iLevel+1 == _levels.size()) {
+        smooth(iLevel, x, rhs, _nbCoarsestSweeps);
+        return;
+    }
+
+    smooth(iLevel, x, rhs, _nbPreSmooth);
+    computeResidual(iLevel, x, rhs);
+
+    /* The coarse level solves for the error, starting from 0 */
+    Level& coarse = _levels[iLevel+1];
+    restrict(level, level.residual, coarse, coarse.rhs);
+    makeCompatible(coarse, coarse.rhs);
+    std::fill(coarse.x.begin(), coarse.x.end(), 0.f);
+    vCycle(iLevel+1, coarse.x, coarse.rhs);
+
+    prolongate(coarse, coarse.x, level, x, true);
+    if (iLevel == 0) {
+        applyBoundaryConditions(x, level.nbCols, level.nbLines, level.pitch, _hFactor, _vFactor);
+    }
+
+    smooth(iLevel, x, rhs, _nbPostSmooth);
+}
+
+void Multigrid::smooth (unsigned int iLevel, BufferFloat& x, BufferFloat const& rhs, unsigned int nbSweeps)
+{
+    Level const& level = _levels[iLevel];
+    const unsigned int nbCols = level.nbCols;
+    const unsigned int pitch = level.pitch;
+
+    /* Gauss-Seidel relaxation */
+    if (iLevel == 0) {
+        const float invDiag = 1.f / (_identity + 4.f * _coupling);
+        for (unsigned int k = 0 ; k < nbSweeps ; ++k) {
+            for (unsigned int line = 1 ; line < level.nbLines-1 ; ++line) {
+                for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+                    unsigned int i = line*pitch + col;
+                    x[i] = (rhs[i] + _coupling * (x[i-pitch] + x[i+pitch] + x[i-1] + x[i+1])) * invDiag;
+                }
+                applyBoundaryLine(x, nbCols, level.nbLines, pitch, line, _hFactor, _vFactor);
+            }
+        }
+        return;
+    }
+
+    /* Coarse levels: the boundaries are folded into the stencils, the outer ring has no weight */
+    Stencil const& a = level.stencil;
+    for (unsigned int k = 0 ; k < nbSweeps ; ++k) {
+        for (unsigned int line = 1 ; line < level.nbLines-1 ; ++line) {
+            for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+                unsigned int i = line*pitch + col;
+                float neighbours = a[0][i] * x[i-pitch-1] + a[1][i] * x[i-pitch] + a[2][i] * x[i-pitch+1] +
+                                   a[3][i] * x[i-1]                                + a[5][i] * x[i+1] +
+                                   a[6][i] * x[i+pitch-1] + a[7][i] * x[i+pitch] + a[8][i] * x[i+pitch+1];
+                x[i] = (rhs[i] - neighbours) / a[4][i];
+            }
+        }
+    }
+}
+
+void Multigrid::computeResidual (unsigned int iLevel, BufferFloat const& x, BufferFloat const& rhs)
+{
+    Level& level = _levels[iLevel];
+    const unsigned int nbCols = level.nbCols;
+    const unsigned int pitch = level.pitch;
+
+    if (iLevel == 0) {
+        const float diag = _identity + 4.f * _coupling;
+        for (unsigned int line = 1 ; line < level.nbLines-1 ; ++line) {
+            for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+                unsigned int i = line*pitch + col;
+                level.residual[i] = rhs[i] - diag * x[i] +
+                                    _coupling * (x[i-pitch] + x[i+pitch] + x[i-1] + x[i+1]);
+            }
+        }
+        return;
+    }
+
+    applyOperator(iLevel, &level.stencil, false, x, level.residual);
+    for (unsigned int line = 1 ; line < level.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < nbCols-1 ; ++col) {
+            unsigned int i = line*pitch + col;
+            level.residual[i] = rhs[i] - level.residual[i];
+        }
+    }
+}
+
+void Multigrid::makeCompatible (Level const& level, BufferFloat& rhs)
+{
+    if (!_singular)
+        return;
+
+    double sum = 0.0, area = 0.0;
+    for (unsigned int line = 1 ; line < level.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < level.nbCols-1 ; ++col) {
+            double cellArea = level.lineAreas[line] * level.colAreas[col];
+            sum += cellArea * rhs[line*level.pitch + col];
+            area += cellArea;
+        }
+    }
+
+    const float mean = sum / area;
+    for (unsigned int line = 1 ; line < level.nbLines-1 ; ++line) {
+        for (unsigned int col = 1 ; col < level.nbCols-1 ; ++col) {
+            rhs[line*level.pitch + col] -= mean;
+        }
+    }
+}
+
+void Multigrid::restrict (Level const& fine, BufferFloat const& fineBuffer, Level const& coarse, BufferFloat& coarseBuffer) const
+{
+    /* The outer ring has no area: when the fine interior has an odd size,
+     * the last coarse cell only gets the last fine cell */
+    for (unsigned int line = 1 ; line < coarse.nbLines-1 ; ++line) {
+        unsigned int line0 = 2*line-1, line1 = 2*line;
+        float lineArea0 = fine.lineAreas[line0], lineArea1 = fine.lineAreas[line1];
+
+        for (unsigned int col = 1 ; col < coarse.nbCols-1 ; ++col) {
+            unsigned int col0 = 2*col-1, col1 = 2*col;
+            float colArea0 = fine.colAreas[col0], colArea1 = fine.colAreas[col1];
+
+            float sum = lineArea0 * (colArea0 * fineBuffer[line0*fine.pitch + col0] +
+                                     colArea1 * fineBuffer[line0*fine.pitch + col1]) +
+                        lineArea1 * (colArea0 * fineBuffer[line1*fine.pitch + col0] +
+                                     colArea1 * fineBuffer[line1*fine.pitch + col1]);
+
+            coarseBuffer[line*coarse.pitch + col] = sum / (coarse.lineAreas[line] * coarse.colAreas[col]);
+        }
+    }
+}
+
+void Multigrid::prolongate (Level const& coarse, BufferFloat& coarseBuffer, Level const& fine, BufferFloat& fineBuffer,
+                            bool add) const
+{
+    /* The coarse outer ring is read for the fine cells along the boundaries */
+    applyBoundaryConditions(coarseBuffer, coarse.nbCols, coarse.nbLines, coarse.pitch, _hFactor, _vFactor);
+
+    for (unsigned int line = 1 ; line < fine.nbLines-1 ; ++line) {
+        /* fine cell centers are at 1/4 of a coarse cell from the closest coarse cell center */
+        unsigned int cLine = (line+1) / 2;
+        unsigned int cLineFar = (line % 2 == 1) ? cLine-1 : cLine+1;
+
+        for (unsigned int col = 1 ; col < fine.nbCols-1 ; ++col) {
+            unsigned int cCol = (col+1) / 2;
+            unsigned int cColFar = (col % 2 == 1) ? cCol-1 : cCol+1;
+
+            float value = 0.5625f * coarseBuffer[cLine*coarse.pitch + cCol] +
+                          0.1875f * (coarseBuffer[cLineFar*coarse.pitch + cCol] +
+                                     coarseBuffer[cLine*coarse.pitch + cColFar]) +
+                          0.0625f * coarseBuffer[cLineFar*coarse.pitch + cColFar];
+
+            unsigned int i = line*fine.pitch + col;
+            fineBuffer[i] = add ? fineBuffer[i] + value : value;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#include "PerfCounters.hpp"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+int PerfCounters::_groupFd = -1;
+int PerfCounters::_fds[4] = {-1, -1, -1, -1};
+
+#ifdef __linux__
+
+/* In the order of the fields of Values */
+static const std::uint64_t EVENTS[4] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static int openEvent (std::uint64_t config, int groupFd)
+{
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = config;
+    attributes.disabled = (groupFd < 0) ? 1 : 0; //the whole group starts with its leader
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_GROUP;
+
+    return syscall(__NR_perf_event_open, &attributes, 0, -1, groupFd, 0); //calling thread, any CPU
+}
+
+bool PerfCounters::open()
+{
+    if (isOpen())
+        return true;
+
+    for (unsigned int i = 0 ; i < 4 ; ++i) {
+        _fds[i] = openEvent(EVENTS[i], (i == 0) ? -1 : _fds[0]);
+        if (_fds[i] < 0) {
+            close();
+            return false;
+        }
+    }
+
+    _groupFd = _fds[0];
+    ioctl(_groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(_groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void PerfCounters::close()
+{
+    for (int& fd : _fds) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = -1;
+    }
+    _groupFd = -1;
+}
+
+PerfCounters::Values PerfCounters::read()
+{
+    Values values = {0, 0, 0, 0};
+    if (!isOpen())
+        return values;
+
+    /* PERF_FORMAT_GROUP: number of events, then their values in the order they were opened */
+    std::uint64_t buffer[1 + 4];
+    if (::read(_groupFd, buffer, sizeof(buffer)) != static_cast<ssize_t>(sizeof(buffer)) || buffer[0] != 4)
+        return values;
+
+    values.cycles = buffer[1];
+    values.instructions = buffer[2];
+    values.llcMisses = buffer[3];
+    values.branchMisses = buffer[4];
+    return values;
+}
+
+#else
+
+bool PerfCounters::open()
+{
+    return false;
+}
+
+void PerfCounters::close()
+{
+}
+
+PerfCounters::Values PerfCounters::read()
+{
+    Values values = {0, 0, 0, 0};
+    return values;
+}
+
+#endif
@@ -0,0 +1,250 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <sstream>
+
+#include "Tracer.hpp"
+
+
+/* Phases in the order they were first met. They are never destroyed, so references to them stay valid. */
+static std::vector<std::unique_ptr<ProfilePhase>>& getRegistry()
+{
+    static std::vector<std::unique_ptr<ProfilePhase>> phases;
+    return phases;
+}
+
+/* Bytes brought in by a last level cache miss */
+static const std::uint64_t CACHE_LINE_SIZE = 64;
+
+static double toMilliseconds (double nanoseconds)
+{
+    return nanoseconds * 1e-6;
+}
+
+ProfilePhase::ProfilePhase (std::string const& name):
+            _name(name),
+            _histogram(NB_BUCKETS, 0)
+{
+    reset();
+}
+
+std::string const& ProfilePhase::getName() const
+{
+    return _name;
+}
+
+void ProfilePhase::record (std::uint64_t nanoseconds)
+{
+    ++_count;
+    _total += nanoseconds;
+    _min = std::min(_min, nanoseconds);
+    _max = std::max(_max, nanoseconds);
+    ++_histogram[getBucket(nanoseconds)];
+}
+
+void ProfilePhase::recordCounters (PerfCounters::Values const& counters, std::uint64_t cells)
+{
+    ++_countedCalls;
+    _counters.cycles += counters.cycles;
+    _counters.instructions += counters.instructions;
+    _counters.llcMisses += counters.llcMisses;
+    _counters.branchMisses += counters.branchMisses;
+    _countedCells += cells;
+}
+
+void ProfilePhase::reset()
+{
+    _count = 0;
+    _total = 0;
+    _min = std::numeric_limits<std::uint64_t>::max();
+    _max = 0;
+    std::fill(_histogram.begin(), _histogram.end(), 0);
+
+    _countedCalls = 0;
+    _counters.cycles = 0;
+    _counters.instructions = 0;
+    _counters.llcMisses = 0;
+    _counters.branchMisses = 0;
+    _countedCells = 0;
+}
+
+std::uint64_t ProfilePhase::getCount() const
+{
+    return _count;
+}
+
+double ProfilePhase::getTotal() const
+{
+    return toMilliseconds(_total);
+}
+
+double ProfilePhase::getMin() const
+{
+    return (_count > 0) ? toMilliseconds(_min) : 0.0;
+}
+
+double ProfilePhase::getMax() const
+{
+    return toMilliseconds(_max);
+}
+
+double ProfilePhase::getMean() const
+{
+    return (_count > 0) ? toMilliseconds(_total) / static_cast<double>(_count) : 0.0;
+}
+
+double ProfilePhase::getPercentile (double fraction) const
+{
+    if (_count == 0)
+        return 0.0;
+
+    const std::uint64_t target = std::max<std::uint64_t>(1, std::ceil(fraction * static_cast<double>(_count)));
+    std::uint64_t cumulated = 0;
+    for (unsigned int bucket = 0 ; bucket < NB_BUCKETS ; ++bucket) {
+        cumulated += _histogram[bucket];
+        if (cumulated >= target)
+            return toMilliseconds(std::min(getBucketUpperBound(bucket), static_cast<double>(_max)));
+    }
+    return getMax();
+}
+
+bool ProfilePhase::hasCounters() const
+{
+    return _countedCalls > 0;
+}
+
+PerfCounters::Values const& ProfilePhase::getCounters() const
+{
+    return _counters;
+}
+
+double ProfilePhase::getInstructionsPerCycle() const
+{
+    return (_counters.cycles > 0) ? static_cast<double>(_counters.instructions) / static_cast<double>(_counters.cycles) : 0.0;
+}
+
+double ProfilePhase::getPerCell (std::uint64_t count) const
+{
+    return (_countedCells > 0) ? static_cast<double>(count) / static_cast<double>(_countedCells) : 0.0;
+}
+
+double ProfilePhase::getBytesPerCell() const
+{
+    return getPerCell(_counters.llcMisses * CACHE_LINE_SIZE);
+}
+
+unsigned int ProfilePhase::getBucket (std::uint64_t nanoseconds)
+{
+    /* Below SUB_BUCKETS, one bucket per nanosecond. Above, the leading bit gives the power of 2
+     * and the 4 following ones the sub-bucket. */
+    if (nanoseconds < SUB_BUCKETS)
+        return nanoseconds;
+
+    const unsigned int exponent = 63 - __builtin_clzll(nanoseconds);
+    const unsigned int subBucket = (nanoseconds >> (exponent - 4)) & (SUB_BUCKETS - 1);
+    return (exponent - 3) * SUB_BUCKETS + subBucket;
+}
+
+double ProfilePhase::getBucketUpperBound (unsigned int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return bucket + 1;
+
+    const unsigned int exponent = bucket / SUB_BUCKETS + 3;
+    const unsigned int subBucket = bucket % SUB_BUCKETS;
+    return std::ldexp(static_cast<double>(SUB_BUCKETS + subBucket + 1), exponent - 4);
+}
+
+ProfilePhase& Profiler::getPhase (std::string const& name)
+{
+    std::vector<std::unique_ptr<ProfilePhase>>& phases = getRegistry();
+    for (std::unique_ptr<ProfilePhase>& phase : phases) {
+        if (phase->getName() == name)
+            return *phase;
+    }
+
+    phases.emplace_back(new ProfilePhase(name));
+    return *phases.back();
+}
+
+std::vector<ProfilePhase const*> Profiler::getPhases()
+{
+    std::vector<ProfilePhase const*> result;
+    for (std::unique_ptr<ProfilePhase> const& phase : getRegistry()) {
+        result.push_back(phase.get());
+    }
+    return result;
+}
+
+void Profiler::reset()
+{
+    for (std::unique_ptr<ProfilePhase>& phase : getRegistry()) {
+        phase->reset();
+    }
+}
+
+void Profiler::writeCsv (std::ostream& stream)
+{
+    stream << "phase,count,total_ms,min_ms,mean_ms,p99_ms,max_ms,"
+           << "ipc,llc_misses_per_cell,bytes_per_cell,branch_misses_per_cell" << std::endl;
+    for (ProfilePhase const* phase : getPhases()) {
+        stream << phase->getName() << "," << phase->getCount() << "," << phase->getTotal() << ","
+               << phase->getMin() << "," << phase->getMean() << "," << phase->getPercentile(0.99) << ","
+               << phase->getMax() << ",";
+        if (phase->hasCounters()) {
+            stream << phase->getInstructionsPerCycle() << "," << phase->getPerCell(phase->getCounters().llcMisses) << ","
+                   << phase->getBytesPerCell() << "," << phase->getPerCell(phase->getCounters().branchMisses);
+        } else {
+            stream << ",,,";
+        }
+        stream << std::endl;
+    }
+}
+
+std::string Profiler::getSummary()
+{
+    std::stringstream s;
+    s << std::fixed << std::setprecision(2);
+    for (ProfilePhase const* phase : getPhases()) {
+        s << phase->getName() << ": " << phase->getMean() << " ms (p99 " << phase->getPercentile(0.99) << ")";
+        if (phase->hasCounters()) {
+            s << ", IPC " << phase->getInstructionsPerCycle();
+            if (phase->getBytesPerCell() > 0.0) {
+                s << ", " << phase->getBytesPerCell() << " B/cell";
+            }
+        }
+        s << std::endl;
+    }
+    return s.str();
+}
+
+ScopedTimer::ScopedTimer (ProfilePhase& phase, std::uint64_t cells):
+            _phase(phase),
+            _cells(cells),
+            _counting(PerfCounters::isOpen()),
+            _startCounters(PerfCounters::read()),
+            _start(std::chrono::steady_clock::now())
+{
+}
+
+ScopedTimer::~ScopedTimer()
+{
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    const PerfCounters::Values counters = PerfCounters::read();
+    _phase.record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - _start).count());
+    if (_counting) {
+        PerfCounters::Values spent;
+        spent.cycles = counters.cycles - _startCounters.cycles;
+        spent.instructions = counters.instructions - _startCounters.instructions;
+        spent.llcMisses = counters.llcMisses - _startCounters.llcMisses;
+        spent.branchMisses = counters.branchMisses - _startCounters.branchMisses;
+        _phase.recordCounters(spent, _cells);
+    }
+    if (Tracer::isRecording()) {
+        Tracer::record(_phase.getName().c_str(), _start, end);
+    }
+}
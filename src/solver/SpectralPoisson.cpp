@@ -0,0 +1,141 @@
+#include "SpectralPoisson.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Boundaries.hpp"
+
+
+/* Number of signals transformed together, one AVX-512 register of floats */
+static const unsigned int BATCH = 16;
+
+SpectralPoisson::SpectralPoisson (unsigned int nbCols, unsigned int nbLines, unsigned int pitch):
+            _nbCols(nbCols),
+            _nbLines(nbLines),
+            _pitch(pitch),
+            _lineTransform(nbLines-2),
+            _colTransform(nbCols-2),
+            _lineEigenvalues(nbLines-2),
+            _colEigenvalues(nbCols-2)
+{
+    const double pi = 3.14159265358979323846;
+    for (unsigned int k = 0 ; k < nbLines-2 ; ++k) {
+        _lineEigenvalues[k] = 2.0 - 2.0 * std::cos(pi * k / (nbLines-2));
+    }
+    for (unsigned int k = 0 ; k < nbCols-2 ; ++k) {
+        _colEigenvalues[k] = 2.0 - 2.0 * std::cos(pi * k / (nbCols-2));
+    }
+
+    _workspaceSize = BATCH * std::max(nbCols, nbLines) +
+                     std::max(_lineTransform.getWorkspaceSize(BATCH), _colTransform.getWorkspaceSize(BATCH));
+    allocateWorkspaces();
+}
+
+bool SpectralPoisson::isSupported (unsigned int nbCols, unsigned int nbLines)
+{
+    return nbCols >= 3 && nbLines >= 3;
+}
+
+void SpectralPoisson::solve (BufferFloat& x, BufferFloat const& rhs, float diag, float coupling)
+{
+    allocateWorkspaces();
+
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        std::copy(rhs.begin() + line*_pitch + 1, rhs.begin() + line*_pitch + _nbCols-1, x.begin() + line*_pitch + 1);
+    }
+
+    transform(x, false);
+
+    /* In the cosine basis the operator is (diag - 4*coupling) + coupling*(lambda_line + lambda_col) */
+    const float identity = diag - 4.f * coupling;
+    for (unsigned int line = 1 ; line < _nbLines-1 ; ++line) {
+        const float lineEigenvalue = identity + coupling * _lineEigenvalues[line-1];
+        for (unsigned int col = 1 ; col < _nbCols-1 ; ++col) {
+            const float eigenvalue = lineEigenvalue + coupling * _colEigenvalues[col-1];
+            float& coefficient = x[line*_pitch + col];
+            coefficient = (eigenvalue != 0.f) ? coefficient / eigenvalue : 0.f;
+        }
+    }
+
+    transform(x, true);
+
+    applyBoundaryConditions(x, _nbCols, _nbLines, _pitch, 1.f, 1.f);
+}
+
+void SpectralPoisson::transform (BufferFloat& x, bool inverse)
+{
+    const unsigned int nbInteriorCols = _nbCols-2, nbInteriorLines = _nbLines-2;
+
+    /* Along the lines: a block of BATCH consecutive columns is already laid out as the Dct expects.
+     * Its lines are read pitch cells apart, which is why a pitch multiple of a large power of 2 hurts. */
+    #pragma omp parallel for schedule(static)
+    for (unsigned int firstCol = 0 ; firstCol < nbInteriorCols ; firstCol += BATCH) {
+        const unsigned int batch = std::min(BATCH, nbInteriorCols - firstCol);
+        float* block = getWorkspace();
+        float* workspace = block + BATCH * std::max(_nbCols, _nbLines);
+
+        for (unsigned int line = 0 ; line < nbInteriorLines ; ++line) {
+            float const* src = x.data() + (line+1)*_pitch + 1 + firstCol;
+            std::copy(src, src + batch, block + line*batch);
+        }
+        if (inverse) {
+            _lineTransform.inverse(block, batch, workspace);
+        } else {
+            _lineTransform.forward(block, batch, workspace);
+        }
+        for (unsigned int line = 0 ; line < nbInteriorLines ; ++line) {
+            std::copy(block + line*batch, block + (line+1)*batch, x.data() + (line+1)*_pitch + 1 + firstCol);
+        }
+    }
+
+    /* Along the columns: a block of BATCH lines is transposed first */
+    #pragma omp parallel for schedule(static)
+    for (unsigned int firstLine = 0 ; firstLine < nbInteriorLines ; firstLine += BATCH) {
+        const unsigned int batch = std::min(BATCH, nbInteriorLines - firstLine);
+        float* block = getWorkspace();
+        float* workspace = block + BATCH * std::max(_nbCols, _nbLines);
+
+        for (unsigned int b = 0 ; b < batch ; ++b) {
+            float const* src = x.data() + (firstLine+b+1)*_pitch + 1;
+            for (unsigned int col = 0 ; col < nbInteriorCols ; ++col) {
+                block[col*batch + b] = src[col];
+            }
+        }
+        if (inverse) {
+            _colTransform.inverse(block, batch, workspace);
+        } else {
+            _colTransform.forward(block, batch, workspace);
+        }
+        for (unsigned int b = 0 ; b < batch ; ++b) {
+            float* dst = x.data() + (firstLine+b+1)*_pitch + 1;
+            for (unsigned int col = 0 ; col < nbInteriorCols ; ++col) {
+                dst[col] = block[col*batch + b];
+            }
+        }
+    }
+}
+
+void SpectralPoisson::allocateWorkspaces()
+{
+#ifdef _OPENMP
+    const unsigned int nbThreads = omp_get_max_threads();
+#else
+    const unsigned int nbThreads = 1;
+#endif
+    if (_workspaces.size() < nbThreads) {
+        _workspaces.resize(nbThreads, BufferFloat(_workspaceSize));
+    }
+}
+
+float* SpectralPoisson::getWorkspace()
+{
+#ifdef _OPENMP
+    return _workspaces[omp_get_thread_num()].data();
+#else
+    return _workspaces[0].data();
+#endif
+}
@@ -0,0 +1,111 @@
+#include "Tracer.hpp"
+
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+struct TraceEvent
+{
+    char const* name;
+    std::int64_t begin; //nanoseconds since start()
+    std::int64_t end;
+};
+
+/* Ring buffer of a thread, only written by that thread */
+struct ThreadEvents
+{
+    unsigned int id;
+    std::vector<TraceEvent> events;
+    std::uint64_t count; //recorded since start(), the last CAPACITY ones are kept
+};
+
+std::atomic<bool> Tracer::_recording(false);
+
+static Tracer::Clock::time_point traceStart;
+
+/* Buffers of all the threads which ever recorded. Only locked when a thread records for the first time. */
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<ThreadEvents>> registry;
+
+static ThreadEvents& getThreadEvents()
+{
+    static thread_local ThreadEvents* events = nullptr;
+    if (events == nullptr) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.emplace_back(new ThreadEvents);
+        events = registry.back().get();
+        events->id = registry.size();
+        events->events.resize(Tracer::CAPACITY);
+        events->count = 0;
+    }
+    return *events;
+}
+
+void Tracer::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (std::unique_ptr<ThreadEvents>& events : registry) {
+            events->count = 0;
+        }
+    }
+    traceStart = Clock::now();
+    _recording.store(true, std::memory_order_release);
+}
+
+void Tracer::stop()
+{
+    _recording.store(false, std::memory_order_release);
+}
+
+void Tracer::record (char const* name, Clock::time_point begin, Clock::time_point end)
+{
+    if (!_recording.load(std::memory_order_acquire))
+        return;
+
+    ThreadEvents& events = getThreadEvents();
+    TraceEvent& event = events.events[events.count % CAPACITY];
+    event.name = name;
+    event.begin = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - traceStart).count();
+    event.end = std::chrono::duration_cast<std::chrono::nanoseconds>(end - traceStart).count();
+    ++events.count;
+}
+
+void Tracer::writeChromeTrace (std::ostream& stream)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    /* Complete events ("X"), timestamps in microseconds */
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+    stream << std::fixed << std::setprecision(3);
+    bool first = true;
+    for (std::unique_ptr<ThreadEvents> const& events : registry) {
+        stream << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << events->id
+               << ",\"args\":{\"name\":\"thread " << events->id << "\"}}";
+        first = false;
+
+        const std::uint64_t oldest = (events->count > CAPACITY) ? events->count - CAPACITY : 0;
+        for (std::uint64_t i = oldest ; i < events->count ; ++i) {
+            TraceEvent const& event = events->events[i % CAPACITY];
+            stream << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << events->id
+                   << ",\"ts\":" << event.begin * 1e-3 << ",\"dur\":" << (event.end - event.begin) * 1e-3 << "}";
+        }
+    }
+    stream << std::endl << "]}" << std::endl;
+}
+
+TraceScope::TraceScope (char const* name):
+            _name(name),
+            _start(Tracer::Clock::now())
+{
+}
+
+TraceScope::~TraceScope()
+{
+    if (Tracer::isRecording()) {
+        Tracer::record(_name, _start, Tracer::Clock::now());
+    }
+}